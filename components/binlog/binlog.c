@@ -0,0 +1,195 @@
+#include "binlog.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "binlog_codec.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "memstat.h"
+
+#if defined(CONFIG_BINLOG_ENABLE)
+
+#define BINLOG_RING_SIZE  (1 << CONFIG_BINLOG_RING_SIZE_LOG2)
+#define BINLOG_STACK_SIZE 3072
+#define BINLOG_PRIORITY   1
+
+// Written only by tasks and interrupts on the owning core, with interrupts masked, and read by
+// the drain task. head and tail run freely, the offset is taken modulo the size.
+typedef struct {
+    uint8_t          buffer[BINLOG_RING_SIZE] __attribute__((aligned(4)));
+    _Atomic uint32_t head;
+    _Atomic uint32_t tail;
+    _Atomic uint32_t dropped;
+} binlog_ring_t;
+
+static binlog_ring_t* rings      = NULL;
+static TaskHandle_t   drain_task = NULL;
+static uint32_t       reported[portNUM_PROCESSORS];  // Drop counts already reported
+
+static void ring_put(binlog_ring_t* ring, uint8_t const* record, uint32_t size) {
+    uint32_t head  = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail  = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    uint32_t start = head % BINLOG_RING_SIZE;
+    uint32_t pad   = BINLOG_RING_SIZE - start < size ? BINLOG_RING_SIZE - start : 0;
+    if (BINLOG_RING_SIZE - (head - tail) < pad + size) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return;
+    }
+    if (pad) {
+        // Records never wrap, skip the end of the buffer
+        uint8_t* filler = &ring->buffer[start];
+        filler[0]       = pad;
+        filler[1]       = pad >> 8;
+        filler[2]       = BINLOG_ID_PAD & 0xFF;
+        filler[3]       = BINLOG_ID_PAD >> 8;
+
+        head  += pad;
+        start  = 0;
+    }
+    memcpy(&ring->buffer[start], record, size);
+    atomic_store_explicit(&ring->head, head + size, memory_order_release);
+}
+
+void binlog_write(uint16_t id, ...) {
+    if (rings == NULL) {
+        return;
+    }
+    uint8_t record[BINLOG_RECORD_MAX] __attribute__((aligned(4)));
+    va_list args;
+    va_start(args, id);
+    size_t size = binlog_encode(record, id, esp_timer_get_time() / 1000, args);
+    va_end(args);
+
+    // Masking interrupts keeps this core's producers from interleaving, without a lock that
+    // the other core could contend on
+    UBaseType_t state = portSET_INTERRUPT_MASK_FROM_ISR();
+    ring_put(&rings[xPortGetCoreID()], record, size);
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(state);
+}
+
+uint32_t binlog_dropped(void) {
+    uint32_t dropped = 0;
+    for (int core = 0; rings && core < portNUM_PROCESSORS; core++) {
+        dropped += atomic_load_explicit(&rings[core].dropped, memory_order_relaxed);
+    }
+    return dropped;
+}
+
+#if defined(CONFIG_BINLOG_OUTPUT_BINARY)
+// One "#BL:<base64 record>" line per record, so the stream survives the console and mixes
+// with regular log output. host/tools/binlog_decode turns it back into text.
+static void binlog_emit(uint8_t const* record, size_t size) {
+    static char const alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    char              line[4 + (BINLOG_RECORD_MAX + 2) / 3 * 4 + 2];
+    size_t            length = 4;
+    memcpy(line, "#BL:", 4);
+    for (size_t i = 0; i < size; i += 3) {
+        uint32_t chunk = record[i] << 16;
+        chunk         |= i + 1 < size ? record[i + 1] << 8 : 0;
+        chunk         |= i + 2 < size ? record[i + 2] : 0;
+        line[length++] = alphabet[(chunk >> 18) & 63];
+        line[length++] = alphabet[(chunk >> 12) & 63];
+        line[length++] = i + 1 < size ? alphabet[(chunk >> 6) & 63] : '=';
+        line[length++] = i + 2 < size ? alphabet[chunk & 63] : '=';
+    }
+    line[length++] = '\n';
+    fwrite(line, 1, length, stdout);
+}
+#else
+static void binlog_emit(uint8_t const* record, size_t size) {
+    char line[BINLOG_RECORD_MAX + 128];
+    if (binlog_format(line, sizeof(line), record, size) >= 0) {
+        puts(line);
+    }
+}
+#endif
+
+static size_t binlog_encode_now(uint8_t* record, uint16_t id, ...) {
+    va_list args;
+    va_start(args, id);
+    size_t size = binlog_encode(record, id, esp_timer_get_time() / 1000, args);
+    va_end(args);
+    return size;
+}
+
+static void binlog_drain(void* arg) {
+    while (1) {
+        for (int core = 0; core < portNUM_PROCESSORS; core++) {
+            binlog_ring_t* ring = &rings[core];
+            uint32_t       tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+            uint32_t       head = atomic_load_explicit(&ring->head, memory_order_acquire);
+            while (tail != head) {
+                uint8_t const* record = &ring->buffer[tail % BINLOG_RING_SIZE];
+                uint16_t       size   = binlog_record_size(record);
+                if (binlog_record_id(record) != BINLOG_ID_PAD) {
+                    binlog_emit(record, size);
+                }
+                tail += size;
+                atomic_store_explicit(&ring->tail, tail, memory_order_release);
+            }
+
+            uint32_t dropped = atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+            if (dropped != reported[core]) {
+                uint8_t record[BINLOG_RECORD_MAX] __attribute__((aligned(4)));
+                binlog_emit(record, binlog_encode_now(record, BINLOG_ID_DROPPED, dropped - reported[core],
+                                                      (uint32_t)core));
+                reported[core] = dropped;
+            }
+        }
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_BINLOG_DRAIN_PERIOD_MS));
+    }
+}
+
+esp_err_t binlog_init(void) {
+    if (rings != NULL) {
+        return ESP_OK;
+    }
+    binlog_ring_t* storage = calloc(portNUM_PROCESSORS, sizeof(binlog_ring_t));
+    if (storage == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    rings = storage;
+    if (memstat_task_create(binlog_drain, "binlog", BINLOG_STACK_SIZE, NULL, BINLOG_PRIORITY, &drain_task,
+                            tskNO_AFFINITY) != pdPASS) {
+        rings = NULL;
+        free(storage);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+#else
+
+esp_err_t binlog_init(void) {
+    return ESP_OK;
+}
+
+void binlog_write(uint16_t id, ...) {
+    (void)id;
+}
+
+uint32_t binlog_dropped(void) {
+    return 0;
+}
+
+esp_log_level_t binlog_level(uint16_t id) {
+    switch (binlog_messages[id].level) {
+        case 'E':
+            return ESP_LOG_ERROR;
+        case 'W':
+            return ESP_LOG_WARN;
+        case 'D':
+            return ESP_LOG_DEBUG;
+        case 'V':
+            return ESP_LOG_VERBOSE;
+        default:
+            return ESP_LOG_INFO;
+    }
+}
+
+char const* binlog_tag(uint16_t id) {
+    return binlog_messages[id].tag;
+}
+#endif
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdint.h>
+#include "binlog_messages.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+// Deferred logging for hot paths. BINLOG(name, ...) copies the message ID and its arguments
+// into a ring buffer owned by the calling core and returns; a low priority task turns the
+// records into console output later. Messages are declared in binlog_messages.h. When the
+// ring is full the message is dropped and counted instead of blocking.
+//
+// Strings are copied (up to BINLOG_STRING_MAX bytes), floating point arguments are not
+// supported.
+
+esp_err_t binlog_init(void);
+void      binlog_write(uint16_t id, ...);
+
+// Messages dropped because the ring of their core was full, since boot
+uint32_t binlog_dropped(void);
+
+// Lets the compiler check the arguments against the message format
+static inline __attribute__((format(printf, 1, 2))) void binlog_check(char const* format, ...) {
+    (void)format;
+}
+
+#if defined(CONFIG_BINLOG_ENABLE)
+#define BINLOG(name, ...)                                   \
+    do {                                                    \
+        if (0) {                                            \
+            binlog_check(BINLOG_FMT_##name, ##__VA_ARGS__); \
+        }                                                   \
+        binlog_write(BINLOG_ID_##name, ##__VA_ARGS__);      \
+    } while (0)
+#else
+esp_log_level_t binlog_level(uint16_t id);
+char const*     binlog_tag(uint16_t id);
+#define BINLOG(name, ...) \
+    ESP_LOG_LEVEL_LOCAL(binlog_level(BINLOG_ID_##name), binlog_tag(BINLOG_ID_##name), BINLOG_FMT_##name, ##__VA_ARGS__)
+#endif
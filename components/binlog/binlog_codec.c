@@ -0,0 +1,201 @@
+#include "binlog_codec.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#define BINLOG_MESSAGE_ENTRY(name, level, tag) [BINLOG_ID_##name] = {level, tag, BINLOG_FMT_##name},
+binlog_message_t const binlog_messages[BINLOG_ID_COUNT] = {BINLOG_MESSAGES(BINLOG_MESSAGE_ENTRY)};
+#undef BINLOG_MESSAGE_ENTRY
+
+// One printf conversion, split into the parts the codec cares about
+typedef struct {
+    char const* start;       // The '%'
+    size_t      spec_length; // Flags, width and precision following the '%'
+    char        length[3];   // Length modifier as written
+    char        conversion;
+    char const* end;         // First character after the conversion
+} conversion_t;
+
+static void put_u16(uint8_t* buf, uint16_t value) {
+    buf[0] = value;
+    buf[1] = value >> 8;
+}
+
+static void put_u32(uint8_t* buf, uint32_t value) {
+    put_u16(buf, value);
+    put_u16(buf + 2, value >> 16);
+}
+
+static uint32_t get_u32(uint8_t const* buf) {
+    return buf[0] | (uint32_t)buf[1] << 8 | (uint32_t)buf[2] << 16 | (uint32_t)buf[3] << 24;
+}
+
+// Find the next conversion in format, skipping "%%". Returns false at the end of the string.
+static bool next_conversion(char const* format, conversion_t* conversion) {
+    while ((format = strchr(format, '%')) != NULL) {
+        if (format[1] == '%') {
+            format += 2;
+            continue;
+        }
+        char const* cursor = format + 1;
+        cursor += strspn(cursor, "-+ #0");
+        cursor += strspn(cursor, "0123456789");
+        if (*cursor == '.') {
+            cursor++;
+            cursor += strspn(cursor, "0123456789");
+        }
+        conversion->start       = format;
+        conversion->spec_length = cursor - format - 1;
+        size_t length           = strspn(cursor, "hljztL");
+        if (length > 2) {
+            length = 2;
+        }
+        memset(conversion->length, 0, sizeof(conversion->length));
+        memcpy(conversion->length, cursor, length);
+        conversion->conversion = cursor[length];
+        conversion->end        = cursor + length + (cursor[length] ? 1 : 0);
+        return true;
+    }
+    return false;
+}
+
+size_t binlog_encode(uint8_t* buf, uint16_t id, uint32_t timestamp_ms, va_list args) {
+    size_t offset = BINLOG_HEADER_SIZE;
+    if (id < BINLOG_ID_COUNT) {
+        char const*  format = binlog_messages[id].format;
+        conversion_t conversion;
+        while (next_conversion(format, &conversion)) {
+            format = conversion.end;
+            if (conversion.conversion == 's') {
+                char const* text   = va_arg(args, char const*);
+                size_t      length = text ? strnlen(text, BINLOG_STRING_MAX) : 0;
+                if (offset + 2 + length > BINLOG_RECORD_MAX) {
+                    break;
+                }
+                buf[offset++] = BINLOG_ARG_STRING;
+                buf[offset++] = length;
+                memcpy(buf + offset, text, length);
+                offset += length;
+                continue;
+            }
+            if (strchr("diouxXcp", conversion.conversion) == NULL) {
+                break;  // Floating point and '*' widths are not supported
+            }
+
+            uint64_t    value;
+            size_t      width;
+            char const* length = conversion.length;
+            if (conversion.conversion == 'p') {
+                value = (uintptr_t)va_arg(args, void*);
+                width = sizeof(void*);
+            } else if (strcmp(length, "ll") == 0 || strcmp(length, "j") == 0) {
+                value = va_arg(args, unsigned long long);
+                width = sizeof(unsigned long long);
+            } else if (strcmp(length, "l") == 0) {
+                value = va_arg(args, unsigned long);
+                width = sizeof(unsigned long);
+            } else if (strcmp(length, "z") == 0 || strcmp(length, "t") == 0) {
+                value = va_arg(args, size_t);
+                width = sizeof(size_t);
+            } else {
+                value = va_arg(args, unsigned int);
+                width = sizeof(unsigned int);
+            }
+            bool quad = width == 8;
+            if (offset + 1 + (quad ? 8 : 4) > BINLOG_RECORD_MAX) {
+                break;
+            }
+            buf[offset++] = quad ? BINLOG_ARG_QUAD : BINLOG_ARG_WORD;
+            put_u32(buf + offset, value);
+            offset += 4;
+            if (quad) {
+                put_u32(buf + offset, value >> 32);
+                offset += 4;
+            }
+        }
+    }
+
+    size_t size = (offset + 3) & ~(size_t)3;
+    memset(buf + offset, 0, size - offset);
+    put_u16(buf, size);
+    put_u16(buf + 2, id);
+    put_u32(buf + 4, timestamp_ms);
+    return size;
+}
+
+static void append(char* out, size_t size, size_t* written, char const* format, ...) {
+    char*   at   = *written < size ? out + *written : NULL;
+    size_t  room = *written < size ? size - *written : 0;
+    va_list args;
+    va_start(args, format);
+    int appended = vsnprintf(at, room, format, args);
+    va_end(args);
+    if (appended > 0) {
+        *written += appended;
+    }
+}
+
+int binlog_format(char* out, size_t size, uint8_t const* record, size_t length) {
+    if (length < BINLOG_HEADER_SIZE || binlog_record_size(record) > length) {
+        return -1;
+    }
+    uint16_t id = binlog_record_id(record);
+    if (id >= BINLOG_ID_COUNT) {
+        return snprintf(out, size, "? (%" PRIu32 ") binlog: unknown message %u", get_u32(record + 4), id);
+    }
+    binlog_message_t const* message = &binlog_messages[id];
+    size_t                  written = 0;
+    append(out, size, &written, "%c (%" PRIu32 ") %s: ", message->level, get_u32(record + 4), message->tag);
+
+    char const*    format = message->format;
+    uint8_t const* arg    = record + BINLOG_HEADER_SIZE;
+    uint8_t const* end    = record + binlog_record_size(record);
+    conversion_t   conversion;
+    while (next_conversion(format, &conversion)) {
+        append(out, size, &written, "%.*s", (int)(conversion.start - format), format);
+        format = conversion.end;
+        if (arg >= end) {
+            append(out, size, &written, "?");
+            continue;
+        }
+
+        // Rebuild the conversion with a length modifier matching this machine
+        char spec[24];
+        int  spec_length = conversion.spec_length < 16 ? (int)conversion.spec_length : 16;
+        char kind        = *arg++;
+        if (kind == BINLOG_ARG_STRING && arg < end && arg + 1 + *arg <= end) {
+            char text[BINLOG_STRING_MAX + 1];
+            memcpy(text, arg + 1, *arg);
+            text[*arg] = '\0';
+            arg += 1 + *arg;
+            snprintf(spec, sizeof(spec), "%%%.*ss", spec_length, conversion.start + 1);
+            append(out, size, &written, spec, text);
+        } else if (kind == BINLOG_ARG_WORD && arg + 4 <= end) {
+            uint32_t value = get_u32(arg);
+            arg += 4;
+            char conv = conversion.conversion == 'p' ? 'x' : conversion.conversion;
+            snprintf(spec, sizeof(spec), "%s%%%.*s%c", conversion.conversion == 'p' ? "0x" : "", spec_length,
+                     conversion.start + 1, conv);
+            if (conv == 'd' || conv == 'i') {
+                append(out, size, &written, spec, (int)(int32_t)value);
+            } else {
+                append(out, size, &written, spec, (unsigned)value);
+            }
+        } else if (kind == BINLOG_ARG_QUAD && arg + 8 <= end) {
+            uint64_t value = get_u32(arg) | (uint64_t)get_u32(arg + 4) << 32;
+            arg += 8;
+            char conv = conversion.conversion == 'p' ? 'x' : conversion.conversion;
+            snprintf(spec, sizeof(spec), "%s%%%.*sll%c", conversion.conversion == 'p' ? "0x" : "", spec_length,
+                     conversion.start + 1, conv);
+            if (conv == 'd' || conv == 'i') {
+                append(out, size, &written, spec, (long long)value);
+            } else {
+                append(out, size, &written, spec, (unsigned long long)value);
+            }
+        } else {
+            return -1;
+        }
+    }
+    append(out, size, &written, "%s", format);
+    return written < size ? (int)written : (int)size - 1;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "binlog_messages.h"
+
+// A record is a header followed by the arguments, each a type byte and the raw value:
+//   u16 size (including header and padding, a multiple of 4), u16 id, u32 timestamp_ms
+//   'w' u32 | 'q' u64 | 's' u8 length, bytes
+// Arguments are stored at the width they were passed with, the decoder rebuilds the
+// conversion for its own ABI, so device and host need not agree on the size of long.
+#define BINLOG_HEADER_SIZE 8
+#define BINLOG_RECORD_MAX  256
+#define BINLOG_STRING_MAX  160
+#define BINLOG_ID_PAD      0xFFFF  // Fills the end of a ring buffer when a record does not fit
+
+#define BINLOG_ARG_WORD   'w'
+#define BINLOG_ARG_QUAD   'q'
+#define BINLOG_ARG_STRING 's'
+
+typedef struct {
+    char        level;  // 'E', 'W', 'I', 'D' or 'V'
+    char const* tag;
+    char const* format;
+} binlog_message_t;
+
+extern binlog_message_t const binlog_messages[BINLOG_ID_COUNT];
+
+// Encode a complete record into buf (BINLOG_RECORD_MAX bytes). Arguments are pulled from args
+// as the message format describes them; strings are truncated to BINLOG_STRING_MAX. Returns
+// the record size.
+size_t binlog_encode(uint8_t* buf, uint16_t id, uint32_t timestamp_ms, va_list args);
+
+// Render a record as an ESP_LOG style line ("I (1234) tag: text") without the newline.
+// Returns the length written, or -1 if the record is malformed.
+int binlog_format(char* out, size_t size, uint8_t const* record, size_t length);
+
+static inline uint16_t binlog_record_size(uint8_t const* record) {
+    return record[0] | (uint16_t)record[1] << 8;
+}
+
+static inline uint16_t binlog_record_id(uint8_t const* record) {
+    return record[2] | (uint16_t)record[3] << 8;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <inttypes.h>
+
+// Messages that can be logged through BINLOG(). Only the message ID and the arguments end up
+// in the ring buffer, the text lives here and is shared with the host decoder.
+//
+// IDs are positions in BINLOG_MESSAGES, so only ever append to the list: binary logs recorded
+// with an older build must keep decoding.
+
+#define BINLOG_FMT_DROPPED          "%" PRIu32 " messages dropped on core %" PRIu32
+#define BINLOG_FMT_SCAN_DONE        "Scan %" PRIu32 " took %" PRId64 " ms, total APs scanned = %u, kept = %u"
+#define BINLOG_FMT_SCAN_AP          "%s"
+#define BINLOG_FMT_SCAN_TABLE       "AP table: %" PRIu32 " APs, %" PRIu32 " inserted, %" PRIu32 " evicted"
+#define BINLOG_FMT_INPUT_KEYBOARD   "Keyboard event %c (%02x) %s"
+#define BINLOG_FMT_INPUT_NAVIGATION "Navigation event %0" PRIX32 ": %s"
+#define BINLOG_FMT_INPUT_ACTION     "Action event 0x%0" PRIX32 ": %s"
+#define BINLOG_FMT_INPUT_SCANCODE   "Scancode event 0x%0" PRIX32
+#define BINLOG_FMT_SCAN_HISTORY     "AP history: %" PRIu32 " APs, %" PRIu32 " updated, %" PRIu32 " dropped"
+
+// X(name, level, tag)
+#define BINLOG_MESSAGES(X)              \
+    X(DROPPED, 'W', "binlog")           \
+    X(SCAN_DONE, 'I', "main")           \
+    X(SCAN_AP, 'I', "main")             \
+    X(SCAN_TABLE, 'I', "main")          \
+    X(INPUT_KEYBOARD, 'I', "main")      \
+    X(INPUT_NAVIGATION, 'I', "main")    \
+    X(INPUT_ACTION, 'I', "main")        \
+    X(INPUT_SCANCODE, 'I', "main")      \
+    X(SCAN_HISTORY, 'I', "main")
+
+#define BINLOG_ID_ENUM(name, level, tag) BINLOG_ID_##name,
+typedef enum {
+    BINLOG_MESSAGES(BINLOG_ID_ENUM) BINLOG_ID_COUNT
+} binlog_id_t;
+#undef BINLOG_ID_ENUM
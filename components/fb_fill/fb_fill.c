@@ -0,0 +1,115 @@
+#include "fb_fill.h"
+#include <stdbool.h>
+#include <string.h>
+#if defined(ESP_PLATFORM)
+#include "sdkconfig.h"
+#endif
+
+// The byte pattern of any pixel size from 1 to 4 repeats every 48 bytes
+#define FILL_PERIOD 48
+
+#if defined(CONFIG_IDF_TARGET_ESP32P4)
+#define FILL_ALIGN 16
+#else
+#define FILL_ALIGN 8
+#endif
+
+uint32_t fb_fill_reverse(uint32_t value, uint8_t bytes_per_pixel) {
+    uint32_t reversed = 0;
+    for (uint8_t i = 0; i < bytes_per_pixel; i++) {
+        reversed = (reversed << 8) | ((value >> (8 * i)) & 0xFF);
+    }
+    return reversed;
+}
+
+#if defined(CONFIG_IDF_TARGET_ESP32P4)
+
+// Store the 48-byte pattern `blocks` times from a 16-byte aligned dst
+static void fill_blocks(uint8_t* dst, size_t blocks, uint8_t const* pattern) {
+    __asm__ volatile(
+        "esp.vld.128.ip q0, %[pattern], 16\n"
+        "esp.vld.128.ip q1, %[pattern], 16\n"
+        "esp.vld.128.ip q2, %[pattern], 16\n"
+        "1:\n"
+        "esp.vst.128.ip q0, %[dst], 16\n"
+        "esp.vst.128.ip q1, %[dst], 16\n"
+        "esp.vst.128.ip q2, %[dst], 16\n"
+        "addi %[blocks], %[blocks], -1\n"
+        "bnez %[blocks], 1b\n"
+        : [dst] "+r"(dst), [blocks] "+r"(blocks), [pattern] "+r"(pattern)
+        :
+        : "memory");
+}
+
+#else
+
+static void fill_blocks(uint8_t* dst, size_t blocks, uint8_t const* pattern) {
+    uint64_t words[FILL_PERIOD / 8];
+    memcpy(words, pattern, sizeof(words));
+    uint64_t* out = (uint64_t*)dst;
+    while (blocks--) {
+        for (size_t i = 0; i < FILL_PERIOD / 8; i++) {
+            *out++ = words[i];
+        }
+    }
+}
+
+#endif
+
+// The bytes of a span filled with one pixel value, long enough to start anywhere in a pixel
+typedef struct {
+    uint8_t bytes_per_pixel;
+    bool    uniform;  // All bytes equal, like black and white, which makes the fill a memset
+    uint8_t bytes[FILL_PERIOD + 3];
+} fill_stream_t;
+
+static void fill_stream_init(fill_stream_t* stream, uint32_t value, uint8_t bytes_per_pixel) {
+    stream->bytes_per_pixel = bytes_per_pixel;
+    stream->uniform         = true;
+    for (uint8_t i = 0; i < bytes_per_pixel; i++) {
+        stream->bytes[i]  = value >> (8 * i);
+        stream->uniform  &= stream->bytes[i] == stream->bytes[0];
+    }
+    for (size_t i = bytes_per_pixel; i < sizeof(stream->bytes); i++) {
+        stream->bytes[i] = stream->bytes[i - bytes_per_pixel];
+    }
+}
+
+static void fill_stream_write(uint8_t* out, size_t bytes, fill_stream_t const* stream) {
+    if (stream->uniform) {
+        memset(out, stream->bytes[0], bytes);
+        return;
+    }
+
+    size_t head = (FILL_ALIGN - ((uintptr_t)out & (FILL_ALIGN - 1))) & (FILL_ALIGN - 1);
+    if (head > bytes) {
+        head = bytes;
+    }
+    memcpy(out, stream->bytes, head);
+
+    // The aligned part starts part way into a pixel
+    uint8_t pattern[FILL_PERIOD] __attribute__((aligned(16)));
+    memcpy(pattern, &stream->bytes[head % stream->bytes_per_pixel], FILL_PERIOD);
+    size_t blocks = (bytes - head) / FILL_PERIOD;
+    if (blocks > 0) {
+        fill_blocks(out + head, blocks, pattern);
+    }
+    size_t done = head + blocks * FILL_PERIOD;
+    memcpy(out + done, pattern, bytes - done);
+}
+
+void fb_fill_span(void* dst, size_t pixels, uint32_t value, uint8_t bytes_per_pixel) {
+    fill_stream_t stream;
+    fill_stream_init(&stream, value, bytes_per_pixel);
+    fill_stream_write(dst, pixels * bytes_per_pixel, &stream);
+}
+
+void fb_fill_rect(void* base, size_t stride, int x, int y, int w, int h, uint32_t value, uint8_t bytes_per_pixel) {
+    fill_stream_t stream;
+    fill_stream_init(&stream, value, bytes_per_pixel);
+    uint8_t* row = (uint8_t*)base + (size_t)y * stride + (size_t)x * bytes_per_pixel;
+    for (int line = 0; line < h; line++) {
+        fill_stream_write(row, (size_t)w * bytes_per_pixel, &stream);
+        row += stride;
+    }
+}
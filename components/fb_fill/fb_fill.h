@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Solid fills of framebuffer memory in any format with whole bytes per pixel (1 to 4). A pixel
+// value is given in the order its bytes sit in memory, least significant byte first. The bulk
+// of every span is written with aligned 128-bit PIE stores on the ESP32-P4 and with aligned
+// 64-bit stores elsewhere; PAX writes one pixel at a time.
+
+// Byte-swap a pixel value, for panels that take their pixels big endian (pax_buf_reversed)
+uint32_t fb_fill_reverse(uint32_t value, uint8_t bytes_per_pixel);
+
+void fb_fill_span(void* dst, size_t pixels, uint32_t value, uint8_t bytes_per_pixel);
+
+// Fill w by h pixels starting at (x, y) of a buffer with rows of `stride` bytes
+void fb_fill_rect(void* base, size_t stride, int x, int y, int w, int h, uint32_t value, uint8_t bytes_per_pixel);
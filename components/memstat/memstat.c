@@ -0,0 +1,226 @@
+#include "memstat.h"
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+#define MEMSTAT_STACK_SIZE 3072
+#define MEMSTAT_PRIORITY   1
+
+#if CONFIG_MEMSTAT_REPORT_INTERVAL_S > 0
+#define MEMSTAT_REPORT_TICKS pdMS_TO_TICKS(CONFIG_MEMSTAT_REPORT_INTERVAL_S * 1000)
+#else
+#define MEMSTAT_REPORT_TICKS portMAX_DELAY
+#endif
+
+typedef struct {
+    TaskHandle_t handle;      // NULL once the task exited, or while it is being created
+    char const*  name;        // Not copied, task names are string literals
+    uint32_t     stack_size;
+    uint32_t     unused;      // Stack never touched, as of the exit of the task
+    bool         exited;
+} memstat_task_t;
+
+static char const TAG[] = "memstat";
+
+static memstat_arena_t* arenas[MEMSTAT_MAX_ARENAS];
+static uint8_t          arena_count = 0;
+static memstat_task_t   tasks[CONFIG_MEMSTAT_MAX_TASKS];
+static uint8_t          task_count  = 0;
+static portMUX_TYPE     task_lock   = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t     report_task = NULL;
+
+esp_err_t memstat_arena_init(memstat_arena_t* arena, char const* name, size_t budget, uint32_t caps) {
+    memset(arena, 0, sizeof(*arena));
+    arena->name   = name;
+    arena->caps   = caps;
+    arena->budget = budget;
+    if (arena_count < MEMSTAT_MAX_ARENAS) {
+        arenas[arena_count++] = arena;
+    }
+    arena->base = heap_caps_aligned_calloc(MEMSTAT_ALIGN, 1, budget, caps);
+    if (arena->base == NULL) {
+        ESP_LOGE(TAG, "Cannot reserve %u B for arena %s", (unsigned)budget, name);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void* memstat_arena_alloc(memstat_arena_t* arena, size_t size) {
+    if (arena == NULL) {
+        return heap_caps_aligned_calloc(MEMSTAT_ALIGN, 1, size, MALLOC_CAP_DEFAULT);
+    }
+    size_t aligned = (size + MEMSTAT_ALIGN - 1) & ~(size_t)(MEMSTAT_ALIGN - 1);
+    if (arena->base != NULL && aligned <= arena->budget - arena->used) {
+        void* block  = arena->base + arena->used;
+        arena->used += aligned;
+        arena->allocations++;
+        return block;
+    }
+
+    if (arena->overflows == 0) {
+        ESP_LOGW(TAG, "Arena %s over budget, %u B more needed", arena->name, (unsigned)aligned);
+    }
+    void* block = heap_caps_aligned_calloc(MEMSTAT_ALIGN, 1, size, arena->caps);
+    if (block) {
+        arena->overflows++;
+        arena->overflow_bytes += aligned;
+        arena->allocations++;
+    }
+    return block;
+}
+
+// Called with task_lock held
+static memstat_task_t* memstat_task_claim(char const* name, uint32_t stack_size) {
+    // A task that runs again, like a trace dump, takes the slot of its earlier run and keeps its
+    // watermark, so the report shows the worst run
+    memstat_task_t* task = NULL;
+    for (uint8_t i = 0; i < task_count && task == NULL; i++) {
+        if (tasks[i].exited && strcmp(tasks[i].name, name) == 0) {
+            task = &tasks[i];
+        }
+    }
+    if (task == NULL) {
+        if (task_count == CONFIG_MEMSTAT_MAX_TASKS) {
+            return NULL;
+        }
+        task         = &tasks[task_count++];
+        task->unused = stack_size;
+    }
+    task->handle     = NULL;
+    task->name       = name;
+    task->stack_size = stack_size;
+    task->unused     = task->unused < stack_size ? task->unused : stack_size;
+    task->exited     = false;
+    return task;
+}
+
+void memstat_task_register(TaskHandle_t handle, char const* name, uint32_t stack_size) {
+    taskENTER_CRITICAL(&task_lock);
+    memstat_task_t* task = memstat_task_claim(name, stack_size);
+    if (task) {
+        task->handle = handle;
+    }
+    taskEXIT_CRITICAL(&task_lock);
+}
+
+BaseType_t memstat_task_create(TaskFunction_t function, char const* name, uint32_t stack_size, void* arg,
+                               UBaseType_t priority, TaskHandle_t* out_handle, BaseType_t core) {
+    // The slot is claimed first, a task that exits before its handle is filled in is found by name
+    taskENTER_CRITICAL(&task_lock);
+    memstat_task_t* task = memstat_task_claim(name, stack_size);
+    taskEXIT_CRITICAL(&task_lock);
+
+    TaskHandle_t handle = NULL;
+    BaseType_t   res    = xTaskCreatePinnedToCore(function, name, stack_size, arg, priority, &handle, core);
+    taskENTER_CRITICAL(&task_lock);
+    if (task && res != pdPASS) {
+        task->exited = true;
+    } else if (task && !task->exited) {
+        task->handle = handle;
+    }
+    taskEXIT_CRITICAL(&task_lock);
+    if (out_handle) {
+        *out_handle = handle;
+    }
+    return res;
+}
+
+// Called with task_lock held
+static uint32_t memstat_task_unused(memstat_task_t const* task) {
+    if (task->handle == NULL) {
+        return task->unused;
+    }
+    uint32_t unused = uxTaskGetStackHighWaterMark(task->handle);
+    return unused < task->unused ? unused : task->unused;
+}
+
+void memstat_task_exit(void) {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    taskENTER_CRITICAL(&task_lock);
+    for (uint8_t i = 0; i < task_count; i++) {
+        memstat_task_t* task    = &tasks[i];
+        bool            pending = task->handle == NULL && !task->exited &&
+                                  strncmp(task->name, pcTaskGetName(self), configMAX_TASK_NAME_LEN - 1) == 0;
+        if (task->handle == self || pending) {
+            uint32_t unused = uxTaskGetStackHighWaterMark(NULL);
+            task->unused    = unused < task->unused ? unused : task->unused;
+            task->handle    = NULL;
+            task->exited    = true;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&task_lock);
+    vTaskDelete(NULL);
+}
+
+static void memstat_report_heap(char const* name, uint32_t caps) {
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, caps);
+    if (info.total_free_bytes + info.total_allocated_bytes == 0) {
+        return;  // No heap with these capabilities
+    }
+    // Share of the free memory that is not part of the largest block
+    uint32_t fragmented =
+        info.total_free_bytes ? 100 - (uint32_t)((uint64_t)info.largest_free_block * 100 / info.total_free_bytes) : 0;
+    ESP_LOGI(TAG, "heap %s: %u B free, %u B largest block, %u B minimum, %" PRIu32 "%% fragmented", name,
+             (unsigned)info.total_free_bytes, (unsigned)info.largest_free_block, (unsigned)info.minimum_free_bytes,
+             fragmented);
+}
+
+void memstat_report(void) {
+    for (uint8_t i = 0; i < arena_count; i++) {
+        memstat_arena_t const* arena = arenas[i];
+        ESP_LOGI(TAG, "arena %s: %u of %u B (%u%%), %" PRIu32 " allocations, %u B over budget", arena->name,
+                 (unsigned)arena->used, (unsigned)arena->budget,
+                 arena->budget ? (unsigned)((uint64_t)arena->used * 100 / arena->budget) : 0, arena->allocations,
+                 (unsigned)arena->overflow_bytes);
+    }
+
+    memstat_report_heap("internal", MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#if defined(CONFIG_SPIRAM)
+    memstat_report_heap("psram", MALLOC_CAP_SPIRAM);
+#endif
+
+    // Copied under the lock, logging with it held would stall the other core
+    memstat_task_t snapshot[CONFIG_MEMSTAT_MAX_TASKS];
+    uint8_t        count;
+    taskENTER_CRITICAL(&task_lock);
+    count = task_count;
+    for (uint8_t i = 0; i < count; i++) {
+        snapshot[i]        = tasks[i];
+        snapshot[i].unused = memstat_task_unused(&tasks[i]);
+    }
+    taskEXIT_CRITICAL(&task_lock);
+    for (uint8_t i = 0; i < count; i++) {
+        ESP_LOGI(TAG, "task %s%s: %" PRIu32 " of %" PRIu32 " B stack never used", snapshot[i].name,
+                 snapshot[i].exited ? " (exited)" : "", snapshot[i].unused, snapshot[i].stack_size);
+    }
+}
+
+static void memstat_report_main(void* arg) {
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, MEMSTAT_REPORT_TICKS);
+        memstat_report();
+    }
+}
+
+esp_err_t memstat_start(void) {
+    if (report_task != NULL) {
+        return ESP_OK;
+    }
+    if (memstat_task_create(memstat_report_main, "memstat", MEMSTAT_STACK_SIZE, NULL, MEMSTAT_PRIORITY, &report_task,
+                            tskNO_AFFINITY) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t memstat_report_request(void) {
+    if (report_task == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xTaskNotifyGive(report_task);
+    return ESP_OK;
+}
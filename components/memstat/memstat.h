@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+// Memory budget bookkeeping. Subsystems take their long-lived storage from an arena with a fixed
+// budget, tasks are created through memstat_task_create() so their stacks can be watched, and
+// memstat_report() logs both together with the state of the heaps:
+//
+//   I memstat: arena scan: 60672 of 81920 B (74%), 5 allocations, 0 B over budget
+//   I memstat: heap internal: 180412 B free, 110592 B largest block, 171004 B minimum, 38% fragmented
+//   I memstat: task render: 1836 of 4096 B stack never used
+
+#define MEMSTAT_MAX_ARENAS 4
+#define MEMSTAT_ALIGN      16
+
+// A bump allocator over one block reserved up front. Nothing is given back, storage is taken once
+// at startup, so the bytes in use are also the high-water mark. Requests beyond the budget come
+// from the heap instead and are counted, so the app keeps running and the report shows by how
+// much the budget was exceeded.
+typedef struct {
+    char const* name;
+    uint32_t    caps;            // heap_caps_malloc() capabilities of the block
+    uint8_t*    base;
+    size_t      budget;
+    size_t      used;
+    uint32_t    allocations;
+    uint32_t    overflows;       // Allocations served from the heap
+    size_t      overflow_bytes;
+} memstat_arena_t;
+
+// Reserve the block and add the arena to the report. ESP_ERR_NO_MEM when the block cannot be
+// reserved, the arena then serves every allocation from the heap, as overflow.
+esp_err_t memstat_arena_init(memstat_arena_t* arena, char const* name, size_t budget, uint32_t caps);
+
+// Zeroed and MEMSTAT_ALIGN aligned, a NULL arena allocates from the heap
+void* memstat_arena_alloc(memstat_arena_t* arena, size_t size);
+
+// xTaskCreatePinnedToCore() that records the task for the report, core may be tskNO_AFFINITY
+BaseType_t memstat_task_create(TaskFunction_t function, char const* name, uint32_t stack_size, void* arg,
+                               UBaseType_t priority, TaskHandle_t* out_handle, BaseType_t core);
+
+// Record a task that was not created through memstat_task_create(), like the main task
+void memstat_task_register(TaskHandle_t handle, char const* name, uint32_t stack_size);
+
+// Replaces vTaskDelete(NULL) in tracked tasks, keeps the final watermark for the report
+void memstat_task_exit(void);
+
+// Start the task that logs the report every CONFIG_MEMSTAT_REPORT_INTERVAL_S seconds
+esp_err_t memstat_start(void);
+
+// Log the report from the caller's task
+void memstat_report(void);
+
+// Have the report task log the report, for callers with little stack
+esp_err_t memstat_report_request(void);
@@ -0,0 +1,161 @@
+#include "ap_cache.h"
+#include <string.h>
+
+#define AP_CACHE_MAX_LOAD(capacity) ((capacity) - (capacity) / 4)
+
+static uint32_t cache_hash(uint8_t const bssid[6]) {
+    // The vendor specific low bytes carry most of the entropy, mix all six anyway
+    uint64_t key = 0;
+    for (int i = 0; i < 6; i++) {
+        key = (key << 8) | bssid[i];
+    }
+    key *= 0x9E3779B97F4A7C15ull;
+    return (uint32_t)(key >> 32);
+}
+
+static uint32_t cache_home(ap_cache_t const* cache, uint8_t const bssid[6]) {
+    return cache_hash(bssid) & (cache->capacity - 1);
+}
+
+static void cache_remove_at(ap_cache_t* cache, uint32_t index) {
+    // Backward shift deletion keeps probe sequences intact without tombstones
+    uint32_t mask = cache->capacity - 1;
+    uint32_t hole = index;
+    uint32_t next = (hole + 1) & mask;
+    while (cache->entries[next].used) {
+        uint32_t home = cache_home(cache, cache->entries[next].record.bssid);
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            cache->entries[hole] = cache->entries[next];
+            hole                 = next;
+        }
+        next = (next + 1) & mask;
+    }
+    cache->entries[hole].used = false;
+    cache->count--;
+    cache->evicted++;
+}
+
+// Remove every entry last seen at the oldest time before now_us. All records of a sweep share one
+// timestamp, so this frees the APs of the oldest sweep at once instead of rescanning the table for
+// every new BSSID. Entries seen at now_us are never evicted, or a big sweep would push out its own
+// first records.
+static bool cache_evict_oldest(ap_cache_t* cache, int64_t now_us) {
+    if (cache->full_us == now_us) {
+        return false;  // Nothing older than this sweep was left
+    }
+    int64_t oldest = now_us;
+    for (uint32_t i = 0; i < cache->capacity; i++) {
+        if (cache->entries[i].used && cache->entries[i].last_seen_us < oldest) {
+            oldest = cache->entries[i].last_seen_us;
+        }
+    }
+    if (oldest == now_us) {
+        cache->full_us = now_us;
+        return false;
+    }
+    uint32_t index = 0;
+    while (index < cache->capacity) {
+        if (cache->entries[index].used && cache->entries[index].last_seen_us == oldest) {
+            cache_remove_at(cache, index);  // Another entry may be shifted into this slot
+            continue;
+        }
+        index++;
+    }
+    return true;
+}
+
+void ap_cache_init(ap_cache_t* cache, ap_cache_entry_t* storage, uint32_t capacity, uint8_t ewma_shift) {
+    cache->entries    = storage;
+    cache->capacity   = capacity;
+    cache->ewma_shift = ewma_shift;
+    ap_cache_clear(cache);
+}
+
+void ap_cache_clear(ap_cache_t* cache) {
+    memset(cache->entries, 0, sizeof(ap_cache_entry_t) * cache->capacity);
+    cache->count    = 0;
+    cache->inserted = 0;
+    cache->evicted  = 0;
+    cache->dropped  = 0;
+    cache->full_us  = INT64_MIN;
+}
+
+ap_cache_entry_t* ap_cache_find(ap_cache_t* cache, uint8_t const bssid[6]) {
+    uint32_t mask  = cache->capacity - 1;
+    uint32_t index = cache_home(cache, bssid);
+    for (uint32_t probes = 0; probes < cache->capacity; probes++) {
+        ap_cache_entry_t* entry = &cache->entries[index];
+        if (!entry->used) {
+            return NULL;
+        }
+        if (memcmp(entry->record.bssid, bssid, 6) == 0) {
+            return entry;
+        }
+        index = (index + 1) & mask;
+    }
+    return NULL;
+}
+
+ap_cache_entry_t* ap_cache_update(ap_cache_t* cache, wifi_ap_record_t const* record, int64_t now_us) {
+    if (cache->capacity == 0) {
+        return NULL;
+    }
+
+    uint32_t mask  = cache->capacity - 1;
+    uint32_t index = cache_home(cache, record->bssid);
+    while (cache->entries[index].used) {
+        ap_cache_entry_t* entry = &cache->entries[index];
+        if (memcmp(entry->record.bssid, record->bssid, 6) == 0) {
+            int32_t sample = (int32_t)record->rssi * (1 << AP_CACHE_RSSI_SHIFT);
+            entry->rssi_avg += (sample - entry->rssi_avg) / (1 << cache->ewma_shift);
+            entry->record       = *record;
+            entry->last_seen_us = now_us;
+            entry->version++;
+            if (entry->seen < UINT16_MAX) {
+                entry->seen++;
+            }
+            return entry;
+        }
+        index = (index + 1) & mask;
+    }
+
+    if (cache->count >= AP_CACHE_MAX_LOAD(cache->capacity)) {
+        if (!cache_evict_oldest(cache, now_us)) {
+            cache->dropped++;
+            return NULL;
+        }
+        // Eviction may have shifted entries, look for a free slot again
+        index = cache_home(cache, record->bssid);
+        while (cache->entries[index].used) {
+            index = (index + 1) & mask;
+        }
+    }
+
+    ap_cache_entry_t* entry = &cache->entries[index];
+    entry->record           = *record;
+    entry->rssi_avg         = (int16_t)(record->rssi * (1 << AP_CACHE_RSSI_SHIFT));
+    entry->seen             = 1;
+    entry->version++;
+    entry->first_seen_us = now_us;
+    entry->last_seen_us  = now_us;
+    entry->used          = true;
+    cache->count++;
+    cache->inserted++;
+    return entry;
+}
+
+uint32_t ap_cache_evict(ap_cache_t* cache, int64_t now_us, int64_t max_age_us) {
+    uint32_t removed = 0;
+    uint32_t index   = 0;
+    while (index < cache->capacity) {
+        ap_cache_entry_t* entry = &cache->entries[index];
+        if (entry->used && now_us - entry->last_seen_us > max_age_us) {
+            // Another entry may be shifted into this slot, check it again
+            cache_remove_at(cache, index);
+            removed++;
+            continue;
+        }
+        index++;
+    }
+    return removed;
+}
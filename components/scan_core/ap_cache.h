@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_wifi_types.h"
+
+// Fractional bits of the smoothed RSSI
+#define AP_CACHE_RSSI_SHIFT 4
+
+typedef struct {
+    wifi_ap_record_t record;         // Most recent record reported for this BSSID
+    int16_t          rssi_avg;       // EWMA of the RSSI, AP_CACHE_RSSI_SHIFT fractional bits
+    uint16_t         seen;           // Number of scans this BSSID appeared in, saturating
+    uint32_t         version;        // Changes whenever the entry is updated
+    int64_t          first_seen_us;
+    int64_t          last_seen_us;
+    bool             used;
+} ap_cache_entry_t;
+
+// Open-addressing (linear probing) table of APs keyed by BSSID, in caller-provided storage
+typedef struct {
+    ap_cache_entry_t* entries;
+    uint32_t          capacity;     // Power of two
+    uint32_t          count;
+    uint8_t           ewma_shift;   // Weight of a new sample is 1 / (1 << ewma_shift)
+    uint32_t          inserted;
+    uint32_t          evicted;
+    uint32_t          dropped;      // New BSSIDs not stored, the table was full with APs of the same sweep
+    int64_t           full_us;      // Sweep timestamp at which nothing was left to evict
+} ap_cache_t;
+
+void ap_cache_init(ap_cache_t* cache, ap_cache_entry_t* storage, uint32_t capacity, uint8_t ewma_shift);
+void ap_cache_clear(ap_cache_t* cache);
+
+// Merge one scan record observed at now_us into the table
+ap_cache_entry_t* ap_cache_update(ap_cache_t* cache, wifi_ap_record_t const* record, int64_t now_us);
+
+ap_cache_entry_t* ap_cache_find(ap_cache_t* cache, uint8_t const bssid[6]);
+
+// Remove all entries not seen since now_us - max_age_us, returns the number removed
+uint32_t ap_cache_evict(ap_cache_t* cache, int64_t now_us, int64_t max_age_us);
+
+static inline int ap_cache_entry_rssi(ap_cache_entry_t const* entry) {
+    return entry->rssi_avg / (1 << AP_CACHE_RSSI_SHIFT);
+}
@@ -0,0 +1,148 @@
+#include "ap_format.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+static char const* const auth_mode_names[WIFI_AUTH_MAX] = {
+    [WIFI_AUTH_OPEN]                    = "OPEN",
+    [WIFI_AUTH_WEP]                     = "WEP",
+    [WIFI_AUTH_WPA_PSK]                 = "WPA_PSK",
+    [WIFI_AUTH_WPA2_PSK]                = "WPA2_PSK",
+    [WIFI_AUTH_WPA_WPA2_PSK]            = "WPA_WPA2_PSK",
+    [WIFI_AUTH_ENTERPRISE]              = "ENTERPRISE",
+    [WIFI_AUTH_WPA3_PSK]                = "WPA3_PSK",
+    [WIFI_AUTH_WPA2_WPA3_PSK]           = "WPA2_WPA3_PSK",
+    [WIFI_AUTH_WAPI_PSK]                = "WAPI_PSK",
+    [WIFI_AUTH_OWE]                     = "OWE",
+    [WIFI_AUTH_WPA3_ENT_192]            = "WPA3_ENT_192",
+    [WIFI_AUTH_WPA3_EXT_PSK]            = "WPA3_EXT_PSK",
+    [WIFI_AUTH_WPA3_EXT_PSK_MIXED_MODE] = "WPA3_EXT_PSK_MIXED",
+    [WIFI_AUTH_DPP]                     = "DPP",
+    [WIFI_AUTH_WPA3_ENTERPRISE]         = "WPA3_ENTERPRISE",
+    [WIFI_AUTH_WPA2_WPA3_ENTERPRISE]    = "WPA2_WPA3_ENTERPRISE",
+};
+
+static char const* const cipher_names[WIFI_CIPHER_TYPE_UNKNOWN + 1] = {
+    [WIFI_CIPHER_TYPE_NONE]        = "NONE",
+    [WIFI_CIPHER_TYPE_WEP40]       = "WEP40",
+    [WIFI_CIPHER_TYPE_WEP104]      = "WEP104",
+    [WIFI_CIPHER_TYPE_TKIP]        = "TKIP",
+    [WIFI_CIPHER_TYPE_CCMP]        = "CCMP",
+    [WIFI_CIPHER_TYPE_TKIP_CCMP]   = "TKIP_CCMP",
+    [WIFI_CIPHER_TYPE_AES_CMAC128] = "AES_CMAC128",
+    [WIFI_CIPHER_TYPE_SMS4]        = "SMS4",
+    [WIFI_CIPHER_TYPE_GCMP]        = "GCMP",
+    [WIFI_CIPHER_TYPE_GCMP256]     = "GCMP256",
+    [WIFI_CIPHER_TYPE_AES_GMAC128] = "AES_GMAC128",
+    [WIFI_CIPHER_TYPE_AES_GMAC256] = "AES_GMAC256",
+    [WIFI_CIPHER_TYPE_UNKNOWN]     = "UNKNOWN",
+};
+
+static char const hex_digits[] = "0123456789ABCDEF";
+
+typedef struct {
+    char*  buf;
+    size_t size;
+    size_t length;
+} line_writer_t;
+
+static inline void put_char(line_writer_t* w, char c) {
+    if (w->length + 1 < w->size) {
+        w->buf[w->length++] = c;
+    }
+}
+
+static inline void put_string(line_writer_t* w, char const* str, size_t max) {
+    for (size_t i = 0; i < max && str[i] != '\0'; i++) {
+        put_char(w, str[i]);
+    }
+}
+
+static inline void put_hex_byte(line_writer_t* w, uint8_t value) {
+    put_char(w, hex_digits[value >> 4]);
+    put_char(w, hex_digits[value & 0xF]);
+}
+
+// Right-aligned in `width` columns
+static void put_int(line_writer_t* w, int value, int width) {
+    char     digits[12];
+    int      count     = 0;
+    bool     negative  = value < 0;
+    unsigned magnitude = negative ? 0u - (unsigned)value : (unsigned)value;
+    do {
+        digits[count++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude > 0);
+    for (int pad = count + negative; pad < width; pad++) {
+        put_char(w, ' ');
+    }
+    if (negative) {
+        put_char(w, '-');
+    }
+    while (count > 0) {
+        put_char(w, digits[--count]);
+    }
+}
+
+static void put_phy(line_writer_t* w, bool present, char const* name, bool* first) {
+    if (!present) {
+        return;
+    }
+    put_string(w, *first ? " 11" : "/", 3);
+    put_string(w, name, 2);
+    *first = false;
+}
+
+char const* ap_format_auth_mode(wifi_auth_mode_t authmode) {
+    if ((unsigned)authmode >= sizeof(auth_mode_names) / sizeof(auth_mode_names[0]) ||
+        auth_mode_names[authmode] == NULL) {
+        return "UNKNOWN";
+    }
+    return auth_mode_names[authmode];
+}
+
+char const* ap_format_cipher(wifi_cipher_type_t cipher) {
+    if ((unsigned)cipher >= sizeof(cipher_names) / sizeof(cipher_names[0]) || cipher_names[cipher] == NULL) {
+        return "UNKNOWN";
+    }
+    return cipher_names[cipher];
+}
+
+size_t ap_format_record(char* buf, size_t size, wifi_ap_record_t const* record) {
+    if (size == 0) {
+        return 0;
+    }
+    line_writer_t w = {.buf = buf, .size = size, .length = 0};
+
+    for (int i = 0; i < 6; i++) {
+        if (i > 0) {
+            put_char(&w, ':');
+        }
+        put_hex_byte(&w, record->bssid[i]);
+    }
+
+    put_string(&w, " ch ", 4);
+    put_int(&w, record->primary, 2);
+    put_char(&w, ' ');
+    put_int(&w, record->rssi, 3);
+    put_string(&w, " dBm ", 5);
+
+    put_string(&w, ap_format_auth_mode(record->authmode), 32);
+    if (record->authmode != WIFI_AUTH_OPEN && record->authmode != WIFI_AUTH_WEP) {
+        put_char(&w, ' ');
+        put_string(&w, ap_format_cipher(record->pairwise_cipher), 32);
+        put_char(&w, '/');
+        put_string(&w, ap_format_cipher(record->group_cipher), 32);
+    }
+
+    bool first = true;
+    put_phy(&w, record->phy_11b, "b", &first);
+    put_phy(&w, record->phy_11g, "g", &first);
+    put_phy(&w, record->phy_11n, "n", &first);
+    put_phy(&w, record->phy_11ax, "ax", &first);
+
+    put_char(&w, ' ');
+    put_string(&w, (char const*)record->ssid, sizeof(record->ssid));
+
+    buf[w.length] = '\0';
+    return w.length;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stddef.h>
+#include "esp_wifi_types.h"
+
+// Longest line ap_format_record() produces, including the terminator
+#define AP_FORMAT_LINE_MAX 128
+
+char const* ap_format_auth_mode(wifi_auth_mode_t authmode);
+char const* ap_format_cipher(wifi_cipher_type_t cipher);
+
+// Write a single line describing the AP into buf without allocating, for example:
+// "AA:BB:CC:DD:EE:FF ch  6 -54 dBm WPA2_PSK CCMP/CCMP 11b/g/n MyNetwork"
+// The output is always terminated and truncated to fit. Returns the length written.
+size_t ap_format_record(char* buf, size_t size, wifi_ap_record_t const* record);
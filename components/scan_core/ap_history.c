@@ -0,0 +1,184 @@
+#include "ap_history.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define AP_HISTORY_MAX_LOAD(capacity) ((capacity) - (capacity) / 4)
+
+static uint32_t history_hash(uint8_t const bssid[6]) {
+    uint64_t key = 0;
+    for (int i = 0; i < 6; i++) {
+        key = (key << 8) | bssid[i];
+    }
+    key *= 0x9E3779B97F4A7C15ull;
+    return (uint32_t)(key >> 32);
+}
+
+static uint32_t history_home(ap_history_t const* history, uint8_t const bssid[6]) {
+    return history_hash(bssid) & (history->capacity - 1);
+}
+
+static void history_remove_at(ap_history_t* history, uint32_t index) {
+    // Backward shift deletion, as in ap_cache.c
+    uint32_t mask = history->capacity - 1;
+    uint32_t hole = index;
+    uint32_t next = (hole + 1) & mask;
+    while (history->slots[next].used) {
+        uint32_t home = history_home(history, history->slots[next].bssid);
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            history->slots[hole] = history->slots[next];
+            hole                 = next;
+        }
+        next = (next + 1) & mask;
+    }
+    history->slots[hole].used = false;
+    history->count--;
+    history->evicted++;
+}
+
+static void history_push(ap_history_slot_t* slot, int8_t sample) {
+    slot->samples[slot->head] = sample;
+    slot->head                = (slot->head + 1) & (AP_HISTORY_SAMPLES - 1);
+    if (slot->count < AP_HISTORY_SAMPLES) {
+        slot->count++;
+    }
+}
+
+void ap_history_init(ap_history_t* history, ap_history_slot_t* storage, uint32_t capacity) {
+    memset(history, 0, sizeof(*history));
+    memset(storage, 0, sizeof(ap_history_slot_t) * capacity);
+    history->slots    = storage;
+    history->capacity = capacity;
+}
+
+void ap_history_begin_scan(ap_history_t* history) {
+    history->scan++;
+    history->updated = 0;
+}
+
+ap_history_slot_t* ap_history_record(ap_history_t* history, wifi_ap_record_t const* record) {
+    if (history->capacity == 0) {
+        return NULL;
+    }
+
+    uint32_t mask  = history->capacity - 1;
+    uint32_t index = history_home(history, record->bssid);
+    while (history->slots[index].used) {
+        ap_history_slot_t* slot = &history->slots[index];
+        if (memcmp(slot->bssid, record->bssid, 6) != 0) {
+            index = (index + 1) & mask;
+            continue;
+        }
+        if (slot->last_scan == history->scan) {
+            // Seen twice in one sweep, keep the stronger sample
+            uint8_t last = (slot->head - 1) & (AP_HISTORY_SAMPLES - 1);
+            if (record->rssi <= slot->samples[last]) {
+                return slot;
+            }
+            slot->samples[last] = record->rssi;
+        } else {
+            uint32_t missed = history->scan - slot->last_scan - 1;
+            for (uint32_t i = 0; i < missed && i < AP_HISTORY_SAMPLES; i++) {
+                history_push(slot, AP_HISTORY_MISSING);
+            }
+            history_push(slot, record->rssi);
+            slot->last_scan = history->scan;
+            history->updated++;
+        }
+        slot->version = ++history->versions;
+        return slot;
+    }
+
+    if (history->count >= AP_HISTORY_MAX_LOAD(history->capacity)) {
+        // Evicting here would make the cost of a scan depend on the table size, wait for
+        // ap_history_end_scan() to make room instead
+        history->dropped++;
+        return NULL;
+    }
+    ap_history_slot_t* slot = &history->slots[index];
+    memset(slot, 0, sizeof(*slot));
+    memcpy(slot->bssid, record->bssid, 6);
+    slot->used      = true;
+    slot->last_scan = history->scan;
+    slot->version   = ++history->versions;
+    history_push(slot, record->rssi);
+    history->count++;
+    history->updated++;
+    return slot;
+}
+
+uint32_t ap_history_end_scan(ap_history_t* history) {
+    uint32_t removed = 0;
+    uint32_t index   = 0;
+    while (index < history->capacity) {
+        ap_history_slot_t* slot = &history->slots[index];
+        if (slot->used && history->scan - slot->last_scan >= AP_HISTORY_SAMPLES) {
+            // Another slot may be shifted into this one, check it again
+            history_remove_at(history, index);
+            removed++;
+            continue;
+        }
+        index++;
+    }
+    return removed;
+}
+
+ap_history_slot_t const* ap_history_find(ap_history_t const* history, uint8_t const bssid[6]) {
+    if (history->capacity == 0) {
+        return NULL;
+    }
+    uint32_t mask  = history->capacity - 1;
+    uint32_t index = history_home(history, bssid);
+    for (uint32_t probes = 0; probes < history->capacity; probes++) {
+        ap_history_slot_t const* slot = &history->slots[index];
+        if (!slot->used) {
+            return NULL;
+        }
+        if (memcmp(slot->bssid, bssid, 6) == 0) {
+            return slot;
+        }
+        index = (index + 1) & mask;
+    }
+    return NULL;
+}
+
+uint8_t ap_history_copy(ap_history_slot_t const* slot, int8_t out[AP_HISTORY_SAMPLES]) {
+    uint8_t first = (slot->head - slot->count) & (AP_HISTORY_SAMPLES - 1);
+    for (uint8_t i = 0; i < slot->count; i++) {
+        out[i] = slot->samples[(first + i) & (AP_HISTORY_SAMPLES - 1)];
+    }
+    return slot->count;
+}
+
+void ap_history_stats(ap_history_slot_t const* slot, ap_history_stats_t* stats) {
+    int8_t  samples[AP_HISTORY_SAMPLES];
+    uint8_t count = ap_history_copy(slot, samples);
+
+    memset(stats, 0, sizeof(*stats));
+    int32_t sum     = 0;
+    int32_t changes = 0;
+    uint8_t pairs   = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        if (samples[i] == AP_HISTORY_MISSING) {
+            stats->missed++;
+            continue;
+        }
+        if (stats->present == 0 || samples[i] < stats->min) {
+            stats->min = samples[i];
+        }
+        if (stats->present == 0 || samples[i] > stats->max) {
+            stats->max = samples[i];
+        }
+        if (i > 0 && samples[i - 1] != AP_HISTORY_MISSING) {
+            changes += abs(samples[i] - samples[i - 1]);
+            pairs++;
+        }
+        sum += samples[i];
+        stats->present++;
+    }
+    if (stats->present > 0) {
+        stats->mean = (int16_t)(sum * (1 << AP_HISTORY_SHIFT) / stats->present);
+    }
+    if (pairs > 0) {
+        stats->jitter = (int16_t)(changes * (1 << AP_HISTORY_SHIFT) / pairs);
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_wifi_types.h"
+
+#define AP_HISTORY_SAMPLES 32        // RSSI samples kept per AP, power of two
+#define AP_HISTORY_MISSING INT8_MIN  // Sample of a scan the AP was not seen in
+#define AP_HISTORY_SHIFT   4         // Fractional bits of the mean and jitter
+
+// Ring of the RSSI of one BSSID over its last AP_HISTORY_SAMPLES scans
+typedef struct {
+    uint8_t  bssid[6];
+    bool     used;
+    uint8_t  head;       // Next sample to overwrite
+    uint8_t  count;      // Samples held, up to AP_HISTORY_SAMPLES
+    uint32_t version;    // Changes with every new sample, never reused by another slot
+    uint32_t last_scan;  // Scan the AP was last seen in
+    int8_t   samples[AP_HISTORY_SAMPLES];
+} ap_history_slot_t;
+
+typedef struct {
+    int8_t  min;
+    int8_t  max;
+    int16_t mean;     // AP_HISTORY_SHIFT fractional bits
+    int16_t jitter;   // Mean change between consecutive samples, AP_HISTORY_SHIFT fractional bits
+    uint8_t present;  // Samples the figures are based on
+    uint8_t missed;   // Scans in the ring that did not see the AP
+} ap_history_stats_t;
+
+// Open-addressing table of RSSI rings keyed by BSSID, in caller-provided storage. Nothing is
+// allocated per sample and the work per scan is bounded: one probe sequence per record, plus one
+// pass over the table in ap_history_end_scan(). Scans an AP was not seen in are only written
+// when it shows up again, so the slots of absent APs keep their version.
+typedef struct {
+    ap_history_slot_t* slots;
+    uint32_t           capacity;  // Power of two
+    uint32_t           count;
+    uint32_t           scan;      // Number of the current scan
+    uint32_t           versions;  // Last version handed out
+    uint32_t           updated;   // Slots that got a sample in the current scan
+    uint32_t           evicted;
+    uint32_t           dropped;   // Records not tracked because the table was full
+} ap_history_t;
+
+void ap_history_init(ap_history_t* history, ap_history_slot_t* storage, uint32_t capacity);
+
+void ap_history_begin_scan(ap_history_t* history);
+
+// Add the RSSI of one record to the current scan
+ap_history_slot_t* ap_history_record(ap_history_t* history, wifi_ap_record_t const* record);
+
+// Forget APs not seen during the last AP_HISTORY_SAMPLES scans, returns the number removed
+uint32_t ap_history_end_scan(ap_history_t* history);
+
+ap_history_slot_t const* ap_history_find(ap_history_t const* history, uint8_t const bssid[6]);
+
+void ap_history_stats(ap_history_slot_t const* slot, ap_history_stats_t* stats);
+
+// Copy the samples oldest first, returns the number copied
+uint8_t ap_history_copy(ap_history_slot_t const* slot, int8_t out[AP_HISTORY_SAMPLES]);
@@ -0,0 +1,259 @@
+#include "ap_list.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t list_hash(uint8_t const bssid[6]) {
+    // FNV-1a, the low bits of a BSSID are already well spread
+    uint32_t hash = 2166136261u;
+    for (uint8_t i = 0; i < 6; i++) {
+        hash = (hash ^ bssid[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Total order: the sort key, then the BSSID, so equal keys do not swap places between syncs
+static int list_compare(ap_list_t const* list, uint16_t a, uint16_t b) {
+    wifi_ap_record_t const* ra  = &list->rows[a].record;
+    wifi_ap_record_t const* rb  = &list->rows[b].record;
+    int                     res = list->compare(ra, rb);
+    return res != 0 ? res : memcmp(ra->bssid, rb->bssid, sizeof(ra->bssid));
+}
+
+static uint16_t list_find(ap_list_t const* list, uint8_t const bssid[6]) {
+    uint32_t slot = list_hash(bssid) & list->index_mask;
+    while (list->index[slot] != 0) {
+        uint16_t row = list->index[slot] - 1;
+        if (memcmp(list->rows[row].record.bssid, bssid, 6) == 0) {
+            return row;
+        }
+        slot = (slot + 1) & list->index_mask;
+    }
+    return UINT16_MAX;
+}
+
+static void list_index_insert(ap_list_t* list, uint16_t row) {
+    uint32_t slot = list_hash(list->rows[row].record.bssid) & list->index_mask;
+    while (list->index[slot] != 0) {
+        slot = (slot + 1) & list->index_mask;
+    }
+    list->index[slot] = row + 1;
+}
+
+// First position in [lo, hi) whose row sorts after `row`
+static uint16_t list_upper_bound(ap_list_t const* list, uint16_t row, uint16_t lo, uint16_t hi) {
+    while (lo < hi) {
+        uint16_t mid = lo + (hi - lo) / 2;
+        if (list_compare(list, list->order[mid], row) > 0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+// Whether a table record differs from a row, the RSSI of the row being the smoothed one
+static bool list_changed(wifi_ap_record_t const* row, wifi_ap_record_t const* record, int rssi) {
+    size_t const before = offsetof(wifi_ap_record_t, rssi);
+    size_t const after  = before + sizeof(record->rssi);
+    return row->rssi != rssi || memcmp(row, record, before) != 0 ||
+           memcmp((uint8_t const*)row + after, (uint8_t const*)record + after, sizeof(*record) - after) != 0;
+}
+
+// Merge two sorted runs of row indices into out
+static void list_merge(ap_list_t const* list, uint16_t const* a, uint16_t a_count, uint16_t const* b,
+                       uint16_t b_count, uint16_t* out) {
+    uint16_t i = 0;
+    uint16_t j = 0;
+    while (i < a_count && j < b_count) {
+        *out++ = list_compare(list, a[i], b[j]) <= 0 ? a[i++] : b[j++];
+    }
+    memcpy(out, &a[i], (a_count - i) * sizeof(uint16_t));
+    memcpy(out + (a_count - i), &b[j], (b_count - j) * sizeof(uint16_t));
+}
+
+// Bottom-up merge sort of rows[0, count), using scratch as the second buffer
+static void list_sort(ap_list_t const* list, uint16_t* rows, uint16_t count, uint16_t* scratch) {
+    uint16_t* from = rows;
+    uint16_t* to   = scratch;
+    for (uint32_t width = 1; width < count; width *= 2) {
+        for (uint32_t lo = 0; lo < count; lo += 2 * width) {
+            uint32_t mid = lo + width < count ? lo + width : count;
+            uint32_t hi  = lo + 2 * width < count ? lo + 2 * width : count;
+            list_merge(list, &from[lo], mid - lo, &from[mid], hi - mid, &to[lo]);
+        }
+        uint16_t* swap = from;
+        from           = to;
+        to             = swap;
+    }
+    if (from != rows) {
+        memcpy(rows, from, count * sizeof(uint16_t));
+    }
+}
+
+// Insertion sort, for rows that are nearly in order already: the cost grows with the number of
+// rows that changed places, not with the square of the count
+static void list_sort_nearly(ap_list_t const* list, uint16_t* rows, uint16_t count) {
+    for (uint16_t i = 1; i < count; i++) {
+        uint16_t row = rows[i];
+        uint16_t j   = i;
+        while (j > 0 && list_compare(list, rows[j - 1], row) > 0) {
+            rows[j] = rows[j - 1];
+            j--;
+        }
+        rows[j] = row;
+    }
+}
+
+static bool list_insert(ap_list_t* list, wifi_ap_record_t const* record) {
+    if (list->count + list->added == list->capacity) {
+        list->dropped++;
+        return false;
+    }
+    uint16_t row = 0;
+    while (list->rows[row].used) {
+        row++;
+    }
+    ap_list_row_t* entry = &list->rows[row];
+    entry->record        = *record;
+    entry->version       = ++list->versions;
+    entry->generation    = list->generation;
+    entry->pending       = true;
+    entry->used          = true;
+    list_index_insert(list, row);
+    list->pending[list->added++] = row;
+    return true;
+}
+
+// Drop rows the last sync did not see and move the changed ones behind the new ones in pending,
+// keeping the order of both the changed rows and the rest
+static uint32_t list_remove_stale(ap_list_t* list) {
+    uint16_t kept    = 0;
+    uint32_t removed = 0;
+
+    list->pending_count = list->added;
+    for (uint16_t i = 0; i < list->count; i++) {
+        uint16_t       row   = list->order[i];
+        ap_list_row_t* entry = &list->rows[row];
+        if (entry->generation != list->generation) {
+            entry->used = false;
+            removed++;
+        } else if (entry->pending) {
+            list->pending[list->pending_count++] = row;
+        } else {
+            list->order[kept++] = row;
+        }
+    }
+    list->count = kept;
+    if (removed > 0) {
+        // Linear probing has no cheap removal, rebuild the index instead
+        memset(list->index, 0, (list->index_mask + 1) * sizeof(uint16_t));
+        for (uint16_t i = 0; i < list->count; i++) {
+            list_index_insert(list, list->order[i]);
+        }
+        for (uint16_t i = 0; i < list->pending_count; i++) {
+            list_index_insert(list, list->pending[i]);
+        }
+    }
+    return removed;
+}
+
+esp_err_t ap_list_init(ap_list_t* list, uint16_t capacity, ap_compare_fn compare) {
+    memset(list, 0, sizeof(*list));
+    uint32_t index_size = 1;
+    while (index_size < 2 * (uint32_t)capacity) {
+        index_size *= 2;
+    }
+    if (index_size > UINT16_MAX + 1u) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    list->rows       = calloc(capacity, sizeof(ap_list_row_t));
+    list->order      = calloc(capacity, sizeof(uint16_t));
+    list->index      = calloc(index_size, sizeof(uint16_t));
+    list->pending    = calloc(capacity, sizeof(uint16_t));
+    list->scratch    = calloc(capacity, sizeof(uint16_t));
+    list->capacity   = capacity;
+    list->index_mask = index_size - 1;
+    list->compare    = compare ? compare : ap_compare_rssi;
+    if (list->rows == NULL || list->order == NULL || list->index == NULL || list->pending == NULL ||
+        list->scratch == NULL) {
+        ap_list_free(list);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void ap_list_free(ap_list_t* list) {
+    free(list->rows);
+    free(list->order);
+    free(list->index);
+    free(list->pending);
+    free(list->scratch);
+    memset(list, 0, sizeof(*list));
+}
+
+uint32_t ap_list_sync(ap_list_t* list, ap_cache_t const* cache) {
+    uint32_t changes = 0;
+    list->generation++;
+    list->added = 0;
+    for (uint32_t i = 0; i < cache->capacity; i++) {
+        ap_cache_entry_t const* entry = &cache->entries[i];
+        if (!entry->used) {
+            continue;
+        }
+        int      rssi = ap_cache_entry_rssi(entry);
+        uint16_t row  = list_find(list, entry->record.bssid);
+        if (row == UINT16_MAX) {
+            wifi_ap_record_t record = entry->record;
+            record.rssi             = rssi;
+            changes += list_insert(list, &record);
+            continue;
+        }
+        ap_list_row_t* existing = &list->rows[row];
+        existing->generation    = list->generation;
+        if (list_changed(&existing->record, &entry->record, rssi)) {
+            existing->record      = entry->record;
+            existing->record.rssi = rssi;
+            existing->version     = ++list->versions;
+            existing->pending     = true;
+            list->moved++;
+            changes++;
+        }
+    }
+    changes += list_remove_stale(list);
+    if (list->pending_count == 0) {
+        return changes;
+    }
+
+    // Only the new and changed rows are sorted, then merged into the rest in one pass. Changed rows
+    // come out of the old order and mostly moved a little, the new ones are in table order.
+    uint16_t* changed       = &list->pending[list->added];
+    uint16_t  changed_count = list->pending_count - list->added;
+    list_sort(list, list->pending, list->added, list->scratch);
+    list_sort_nearly(list, changed, changed_count);
+    if (list->added > 0 && changed_count > 0) {
+        list_merge(list, list->pending, list->added, changed, changed_count, list->scratch);
+        memcpy(list->pending, list->scratch, list->pending_count * sizeof(uint16_t));
+    }
+    list_merge(list, list->order, list->count, list->pending, list->pending_count, list->scratch);
+    for (uint16_t i = 0; i < list->pending_count; i++) {
+        list->rows[list->pending[i]].pending = false;
+    }
+    uint16_t* order = list->order;
+    list->order     = list->scratch;
+    list->scratch   = order;
+    list->count    += list->pending_count;
+    return changes;
+}
+
+void ap_list_set_compare(ap_list_t* list, ap_compare_fn compare) {
+    list->compare = compare;
+    // Binary insertion sort, the list holds a few hundred rows at most
+    for (uint16_t i = 1; i < list->count; i++) {
+        uint16_t row    = list->order[i];
+        uint16_t target = list_upper_bound(list, row, 0, i);
+        memmove(&list->order[target + 1], &list->order[target], (i - target) * sizeof(uint16_t));
+        list->order[target] = row;
+    }
+}
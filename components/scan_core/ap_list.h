@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ap_cache.h"
+#include "ap_topk.h"
+#include "esp_err.h"
+#include "esp_wifi_types.h"
+
+// Sorted view of the AP table for display. The order is maintained incrementally as scans
+// merge in: new APs and APs whose record changed are taken out, sorted among themselves and
+// merged back into the rest, which is still in order. Changed APs are taken out in their old
+// order and mostly move a little, so sorting them costs little more than a pass over them.
+// Only a change of sort key sorts everything again.
+
+typedef struct {
+    wifi_ap_record_t record;      // rssi holds the smoothed RSSI of the table
+    uint32_t         version;     // Changes whenever the record changes, never reused by another row
+    uint32_t         generation;  // Last sync that found this AP in the table
+    bool             pending;     // Added or changed by the running sync, not in order yet
+    bool             used;
+} ap_list_row_t;
+
+typedef struct {
+    ap_list_row_t* rows;
+    uint16_t*      order;      // Row indices, best first
+    uint16_t*      scratch;    // Second order buffer, the two are swapped after a merge
+    uint16_t*      pending;    // Rows added, then rows changed by the running sync
+    uint16_t*      index;      // Open-addressing table of row + 1 keyed by BSSID, 0 when empty
+    uint16_t       capacity;
+    uint16_t       index_mask;
+    uint16_t       count;
+    uint16_t       added;      // Rows added by the running sync, at the start of pending
+    uint16_t       pending_count;
+    uint32_t       generation;
+    uint32_t       versions;   // Last version handed out
+    ap_compare_fn  compare;
+    uint32_t       moved;      // Changed rows merged back into the order since init, for profiling
+    uint32_t       dropped;    // APs not listed because the list was full
+} ap_list_t;
+
+esp_err_t ap_list_init(ap_list_t* list, uint16_t capacity, ap_compare_fn compare);
+void      ap_list_free(ap_list_t* list);
+
+// Merge the current contents of the table. Returns the number of rows added, changed or removed.
+uint32_t ap_list_sync(ap_list_t* list, ap_cache_t const* cache);
+
+// Change the sort key, the only operation that sorts the whole list
+void ap_list_set_compare(ap_list_t* list, ap_compare_fn compare);
+
+static inline ap_list_row_t const* ap_list_at(ap_list_t const* list, uint16_t position) {
+    return &list->rows[list->order[position]];
+}
@@ -0,0 +1,286 @@
+#include "ap_rank.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SIGNAL_FLOOR    (-90)  // dBm, worth nothing
+#define SIGNAL_CEILING  (-40)  // dBm, anything stronger is not any better
+#define OVERLAP         4      // 2.4 GHz channels this far apart still share spectrum
+#define CONGESTION_MAX  30
+#define FAILURE_PENALTY 40  // As much as 20 dB of signal
+#define FAILURE_DECAY   8   // Updates after which one failure is forgotten
+#define CURRENT_BONUS   8
+#define ESS_MAX_LOAD    (AP_RANK_MAX_ESS - AP_RANK_MAX_ESS / 4)
+
+static int16_t rank_signal(int rssi) {
+    rssi = rssi < SIGNAL_FLOOR ? SIGNAL_FLOOR : rssi > SIGNAL_CEILING ? SIGNAL_CEILING : rssi;
+    return (int16_t)((rssi - SIGNAL_FLOOR) * 100 / (SIGNAL_CEILING - SIGNAL_FLOOR));
+}
+
+static int16_t rank_phy(wifi_ap_record_t const* record) {
+    if (record->phy_11ax) {
+        return 15;
+    }
+    if (record->phy_11n) {
+        return 10;
+    }
+    if (record->phy_11g) {
+        return 0;
+    }
+    return -20;  // 11b only, slows down every station in range
+}
+
+static int16_t rank_security(wifi_ap_record_t const* record) {
+    int16_t score;
+    switch (record->authmode) {
+        case WIFI_AUTH_WPA3_PSK:
+        case WIFI_AUTH_WPA3_EXT_PSK:
+        case WIFI_AUTH_WPA3_ENT_192:
+        case WIFI_AUTH_WPA3_ENTERPRISE:
+            score = 10;
+            break;
+        case WIFI_AUTH_WPA2_WPA3_PSK:
+        case WIFI_AUTH_WPA3_EXT_PSK_MIXED_MODE:
+        case WIFI_AUTH_WPA2_WPA3_ENTERPRISE:
+        case WIFI_AUTH_WPA2_ENTERPRISE:
+        case WIFI_AUTH_OWE:
+            score = 5;
+            break;
+        case WIFI_AUTH_WPA2_PSK:
+            score = 0;
+            break;
+        default:
+            score = -10;  // Open, WEP, WPA
+            break;
+    }
+    if (record->pairwise_cipher == WIFI_CIPHER_TYPE_TKIP || record->pairwise_cipher == WIFI_CIPHER_TYPE_WEP40 ||
+        record->pairwise_cipher == WIFI_CIPHER_TYPE_WEP104) {
+        score -= 15;  // No 11n rates with these ciphers
+    }
+    return score;
+}
+
+// Other APs sharing spectrum with the channel, co-channel ones counting fully
+static int16_t rank_congestion(ap_rank_t const* rank, uint8_t channel) {
+    if (channel == 0 || channel > AP_RANK_CHANNELS) {
+        return 0;
+    }
+    int load = -(OVERLAP + 1);  // Leave out the AP itself
+    for (int other = channel - OVERLAP; other <= channel + OVERLAP; other++) {
+        if (other >= 1 && other <= AP_RANK_CHANNELS) {
+            load += rank->channel_aps[other] * (OVERLAP + 1 - abs(other - channel));
+        }
+    }
+    int penalty = load * 3 / (OVERLAP + 1);
+    return (int16_t)(penalty < 0 ? 0 : penalty > CONGESTION_MAX ? CONGESTION_MAX : penalty);
+}
+
+static uint32_t ess_hash(uint8_t const* ssid) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < 32 && ssid[i]; i++) {
+        hash = (hash ^ ssid[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static void rank_group(ap_rank_t* rank, ap_cache_entry_t const* entry) {
+    uint8_t const* ssid = entry->record.ssid;
+    if (ssid[0] == '\0') {
+        return;  // Hidden networks cannot be told apart
+    }
+    // Probing stops at the first free slot, and a quarter of the slots are always free
+    uint32_t index = ess_hash(ssid) % AP_RANK_MAX_ESS;
+    while (rank->ess[index].bssids != 0) {
+        ap_rank_ess_t* ess = &rank->ess[index];
+        if (strncmp((char const*)ess->ssid, (char const*)ssid, sizeof(ess->ssid)) == 0) {
+            ess->bssids++;
+            if (ap_cache_entry_rssi(entry) > ess->best_rssi) {
+                ess->best_rssi = ap_cache_entry_rssi(entry);
+            }
+            return;
+        }
+        index = (index + 1) % AP_RANK_MAX_ESS;
+    }
+    if (rank->ess_count >= ESS_MAX_LOAD) {
+        rank->ess_dropped++;
+        return;
+    }
+    ap_rank_ess_t* ess = &rank->ess[index];
+    memcpy(ess->ssid, ssid, sizeof(ess->ssid));
+    ess->bssids    = 1;
+    ess->best_rssi = ap_cache_entry_rssi(entry);
+    rank->ess_count++;
+}
+
+static ap_rank_failure_t* rank_find_failure(ap_rank_t* rank, uint8_t const bssid[6]) {
+    for (uint8_t i = 0; i < AP_RANK_MAX_FAILURES; i++) {
+        if (rank->failed[i].count > 0 && memcmp(rank->failed[i].bssid, bssid, 6) == 0) {
+            return &rank->failed[i];
+        }
+    }
+    return NULL;
+}
+
+static ap_rank_candidate_t* rank_find(ap_rank_t* rank, uint8_t const bssid[6]) {
+    for (uint8_t i = 0; i < rank->count; i++) {
+        if (memcmp(rank->candidates[i].bssid, bssid, 6) == 0) {
+            return &rank->candidates[i];
+        }
+    }
+    return NULL;
+}
+
+static void rank_score(ap_rank_t* rank, ap_rank_candidate_t* candidate, ap_cache_entry_t const* entry) {
+    wifi_ap_record_t const* record = &entry->record;
+    memcpy(candidate->bssid, record->bssid, 6);
+    candidate->channel  = record->primary;
+    candidate->authmode = record->authmode;
+    candidate->rssi     = ap_cache_entry_rssi(entry);
+    candidate->seen     = rank->updates;
+
+    ap_rank_failure_t const* failure = rank_find_failure(rank, candidate->bssid);
+    candidate->signal                = rank_signal(candidate->rssi);
+    candidate->phy                   = rank_phy(record);
+    candidate->security              = rank_security(record);
+    candidate->congestion            = rank_congestion(rank, candidate->channel);
+    candidate->failures              = failure ? failure->count * FAILURE_PENALTY : 0;
+
+    int score = candidate->signal + candidate->phy + candidate->security - candidate->congestion - candidate->failures;
+    if (rank->connected && memcmp(rank->current, candidate->bssid, 6) == 0) {
+        score += CURRENT_BONUS;
+    }
+    candidate->score = (int16_t)score;
+}
+
+// Only called for BSSIDs that are not candidates yet, once all candidates have been rescored
+static void rank_offer(ap_rank_t* rank, ap_cache_entry_t const* entry) {
+    ap_rank_candidate_t fresh = {0};
+    rank_score(rank, &fresh, entry);
+    if (rank->count < AP_RANK_MAX_CANDIDATES) {
+        rank->candidates[rank->count++] = fresh;
+        return;
+    }
+    // Full, replace the worst candidate if the new one beats it
+    uint8_t worst = 0;
+    for (uint8_t i = 1; i < rank->count; i++) {
+        if (rank->candidates[i].score < rank->candidates[worst].score) {
+            worst = i;
+        }
+    }
+    if (fresh.score > rank->candidates[worst].score) {
+        rank->candidates[worst] = fresh;
+    }
+}
+
+static bool rank_is_target(ap_rank_t const* rank, ap_cache_entry_t const* entry) {
+    return entry->used &&
+           strncmp((char const*)entry->record.ssid, (char const*)rank->target, sizeof(rank->target)) == 0;
+}
+
+void ap_rank_init(ap_rank_t* rank) {
+    memset(rank, 0, sizeof(*rank));
+}
+
+void ap_rank_set_target(ap_rank_t* rank, char const* ssid) {
+    memset(rank->target, 0, sizeof(rank->target));
+    strncpy((char*)rank->target, ssid, sizeof(rank->target) - 1);
+    memset(rank->failed, 0, sizeof(rank->failed));
+    rank->count     = 0;
+    rank->connected = false;
+}
+
+void ap_rank_update(ap_rank_t* rank, ap_cache_t const* cache) {
+    rank->updates++;
+    for (uint8_t i = 0; i < AP_RANK_MAX_FAILURES; i++) {
+        ap_rank_failure_t* failure = &rank->failed[i];
+        if (failure->count > 0 && rank->updates - failure->at >= FAILURE_DECAY) {
+            failure->count--;
+            failure->at = rank->updates;
+        }
+    }
+    memset(rank->channel_aps, 0, sizeof(rank->channel_aps));
+    memset(rank->ess, 0, sizeof(rank->ess));
+    rank->ess_count   = 0;
+    rank->ess_dropped = 0;
+
+    // Congestion has to be known before any candidate is scored
+    for (uint32_t i = 0; i < cache->capacity; i++) {
+        ap_cache_entry_t const* entry = &cache->entries[i];
+        if (!entry->used) {
+            continue;
+        }
+        if (entry->record.primary >= 1 && entry->record.primary <= AP_RANK_CHANNELS) {
+            rank->channel_aps[entry->record.primary]++;
+        }
+        rank_group(rank, entry);
+    }
+    if (rank->target[0] == '\0') {
+        return;
+    }
+
+    // Rescore the candidates first and drop those that left the table, so newcomers compete
+    // against current scores and replacing a candidate never throws away a failure history
+    for (uint32_t i = 0; i < cache->capacity; i++) {
+        ap_cache_entry_t const* entry = &cache->entries[i];
+        if (rank_is_target(rank, entry)) {
+            ap_rank_candidate_t* candidate = rank_find(rank, entry->record.bssid);
+            if (candidate) {
+                rank_score(rank, candidate, entry);
+            }
+        }
+    }
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < rank->count; i++) {
+        if (rank->candidates[i].seen == rank->updates) {
+            rank->candidates[kept++] = rank->candidates[i];
+        }
+    }
+    rank->count = kept;
+    for (uint32_t i = 0; i < cache->capacity; i++) {
+        ap_cache_entry_t const* entry = &cache->entries[i];
+        if (rank_is_target(rank, entry) && rank_find(rank, entry->record.bssid) == NULL) {
+            rank_offer(rank, entry);
+        }
+    }
+
+    // Scores move a little with every scan, so the order is nearly right already
+    for (uint8_t i = 1; i < rank->count; i++) {
+        ap_rank_candidate_t candidate = rank->candidates[i];
+        uint8_t             j         = i;
+        while (j > 0 && rank->candidates[j - 1].score < candidate.score) {
+            rank->candidates[j] = rank->candidates[j - 1];
+            j--;
+        }
+        rank->candidates[j] = candidate;
+    }
+}
+
+void ap_rank_report(ap_rank_t* rank, uint8_t const bssid[6], bool success) {
+    ap_rank_failure_t* failure = rank_find_failure(rank, bssid);
+    if (success) {
+        memcpy(rank->current, bssid, 6);
+        rank->connected = true;
+        if (failure) {
+            failure->count = 0;
+        }
+        return;
+    }
+    if (failure == NULL) {
+        // Take a free slot, or the one that failed longest ago
+        failure = &rank->failed[0];
+        for (uint8_t i = 0; i < AP_RANK_MAX_FAILURES && failure->count > 0; i++) {
+            if (rank->failed[i].count == 0 || rank->failed[i].at < failure->at) {
+                failure = &rank->failed[i];
+            }
+        }
+        memcpy(failure->bssid, bssid, 6);
+        failure->count = 0;
+    }
+    if (failure->count < UINT8_MAX) {
+        failure->count++;
+    }
+    failure->at = rank->updates;
+}
+
+void ap_rank_disconnected(ap_rank_t* rank) {
+    rank->connected = false;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ap_cache.h"
+#include "esp_wifi_types.h"
+
+#define AP_RANK_MAX_CANDIDATES 16  // BSSIDs of the target network that are ranked
+#define AP_RANK_MAX_ESS        32  // Networks summarized per update
+#define AP_RANK_MAX_FAILURES   8   // BSSIDs whose failed connection attempts are remembered
+#define AP_RANK_CHANNELS       14
+
+// A BSSID of the target network and how its score came about
+typedef struct {
+    uint8_t          bssid[6];
+    uint8_t          channel;
+    wifi_auth_mode_t authmode;
+    int8_t           rssi;        // Smoothed
+    int16_t          score;       // Sum of the parts below
+    int16_t          signal;
+    int16_t          phy;
+    int16_t          security;
+    int16_t          congestion;  // Penalty for other APs on overlapping channels
+    int16_t          failures;    // Penalty for recent failed connection attempts
+    uint32_t         seen;        // Last update that found this BSSID
+} ap_rank_candidate_t;
+
+// Kept apart from the candidates, so a BSSID that drops off the list and comes back is still
+// remembered as failing
+typedef struct {
+    uint8_t  bssid[6];
+    uint8_t  count;  // Recent failed attempts, 0 for a free slot
+    uint32_t at;     // Update of the last failure
+} ap_rank_failure_t;
+
+// All BSSIDs sharing one SSID
+typedef struct {
+    uint8_t  ssid[33];
+    uint16_t bssids;
+    int8_t   best_rssi;
+} ap_rank_ess_t;
+
+// Ranks the BSSIDs of one network as connection candidates, best first. Every update groups the
+// AP table by SSID, counts APs per channel and rescores the candidates, taking failed connection
+// attempts of earlier updates into account. Candidates are kept sorted with an insertion sort,
+// which is linear when the order barely changed since the previous scan.
+typedef struct {
+    uint8_t             target[33];
+    uint8_t             current[6];  // BSSID we are connected to, gets a bonus against roaming on noise
+    bool                connected;
+    uint32_t            updates;
+    uint16_t            channel_aps[AP_RANK_CHANNELS + 1];
+    ap_rank_ess_t       ess[AP_RANK_MAX_ESS];
+    uint16_t            ess_count;
+    uint16_t            ess_dropped;  // Networks not summarized because the table was full
+    ap_rank_candidate_t candidates[AP_RANK_MAX_CANDIDATES];
+    uint8_t             count;
+    ap_rank_failure_t   failed[AP_RANK_MAX_FAILURES];
+} ap_rank_t;
+
+void ap_rank_init(ap_rank_t* rank);
+
+// Rank the BSSIDs of another network, drops all candidates
+void ap_rank_set_target(ap_rank_t* rank, char const* ssid);
+
+// Rescore against the current contents of the AP table, call after every scan
+void ap_rank_update(ap_rank_t* rank, ap_cache_t const* cache);
+
+// Outcome of a connection attempt. Failures push a BSSID down the list until it has been left
+// alone for a while, a success makes it the current BSSID.
+void ap_rank_report(ap_rank_t* rank, uint8_t const bssid[6], bool success);
+
+void ap_rank_disconnected(ap_rank_t* rank);
@@ -0,0 +1,84 @@
+#include "ap_topk.h"
+#include <string.h>
+
+static void topk_swap(wifi_ap_record_t* a, wifi_ap_record_t* b) {
+    wifi_ap_record_t tmp = *a;
+    *a                   = *b;
+    *b                   = tmp;
+}
+
+static void topk_sift_up(ap_topk_t* topk, uint16_t index) {
+    while (index > 0) {
+        uint16_t parent = (index - 1) / 2;
+        if (topk->compare(&topk->records[index], &topk->records[parent]) <= 0) {
+            break;
+        }
+        topk_swap(&topk->records[index], &topk->records[parent]);
+        index = parent;
+    }
+}
+
+static void topk_sift_down(ap_topk_t* topk, uint16_t index, uint16_t count) {
+    while (1) {
+        uint32_t child = 2 * (uint32_t)index + 1;
+        if (child >= count) {
+            break;
+        }
+        if (child + 1 < count && topk->compare(&topk->records[child + 1], &topk->records[child]) > 0) {
+            child++;
+        }
+        if (topk->compare(&topk->records[child], &topk->records[index]) <= 0) {
+            break;
+        }
+        topk_swap(&topk->records[index], &topk->records[child]);
+        index = child;
+    }
+}
+
+void ap_topk_init(ap_topk_t* topk, wifi_ap_record_t* storage, uint16_t capacity, ap_compare_fn compare) {
+    topk->records  = storage;
+    topk->capacity = capacity;
+    topk->compare  = compare ? compare : ap_compare_rssi;
+    ap_topk_reset(topk);
+}
+
+void ap_topk_reset(ap_topk_t* topk) {
+    topk->count   = 0;
+    topk->offered = 0;
+}
+
+void ap_topk_offer(ap_topk_t* topk, wifi_ap_record_t const* record) {
+    topk->offered++;
+    if (topk->count < topk->capacity) {
+        topk->records[topk->count] = *record;
+        topk_sift_up(topk, topk->count);
+        topk->count++;
+        return;
+    }
+    if (topk->capacity == 0 || topk->compare(record, &topk->records[0]) >= 0) {
+        return;  // Not better than the worst record kept so far
+    }
+    topk->records[0] = *record;
+    topk_sift_down(topk, 0, topk->count);
+}
+
+void ap_topk_sort(ap_topk_t* topk) {
+    for (uint16_t end = topk->count; end > 1; end--) {
+        topk_swap(&topk->records[0], &topk->records[end - 1]);
+        topk_sift_down(topk, 0, end - 1);
+    }
+}
+
+int ap_compare_rssi(wifi_ap_record_t const* a, wifi_ap_record_t const* b) {
+    return (int)b->rssi - (int)a->rssi;
+}
+
+int ap_compare_ssid(wifi_ap_record_t const* a, wifi_ap_record_t const* b) {
+    int res = strncmp((char const*)a->ssid, (char const*)b->ssid, sizeof(a->ssid));
+    return res != 0 ? res : ap_compare_rssi(a, b);
+}
+
+int ap_compare_channel(wifi_ap_record_t const* a, wifi_ap_record_t const* b) {
+    int res = (int)a->primary - (int)b->primary;
+    return res != 0 ? res : ap_compare_rssi(a, b);
+}
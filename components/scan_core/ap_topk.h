@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_wifi_types.h"
+
+// Ordering used to rank AP records, negative when a should be listed before b
+typedef int (*ap_compare_fn)(wifi_ap_record_t const* a, wifi_ap_record_t const* b);
+
+// Keeps the best `capacity` records out of any number offered, in caller-provided storage.
+// While collecting, the records form a heap with the worst kept record at the root.
+typedef struct {
+    wifi_ap_record_t* records;
+    uint16_t          capacity;
+    uint16_t          count;
+    uint32_t          offered;  // Number of records offered since the last reset
+    ap_compare_fn     compare;
+} ap_topk_t;
+
+void ap_topk_init(ap_topk_t* topk, wifi_ap_record_t* storage, uint16_t capacity, ap_compare_fn compare);
+void ap_topk_reset(ap_topk_t* topk);
+void ap_topk_offer(ap_topk_t* topk, wifi_ap_record_t const* record);
+
+// Sort the kept records best first. Reset before offering new records afterwards.
+void ap_topk_sort(ap_topk_t* topk);
+
+int ap_compare_rssi(wifi_ap_record_t const* a, wifi_ap_record_t const* b);
+int ap_compare_ssid(wifi_ap_record_t const* a, wifi_ap_record_t const* b);
+int ap_compare_channel(wifi_ap_record_t const* a, wifi_ap_record_t const* b);
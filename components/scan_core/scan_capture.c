@@ -0,0 +1,220 @@
+#include "scan_capture.h"
+#include <string.h>
+
+#define CAPTURE_MAGIC     "WSCP"
+#define RECORD_FIXED_SIZE 16  // Encoded record without the SSID
+#define RECORD_SSID_MAX   32
+
+#define PHY_11B           (1 << 0)
+#define PHY_11G           (1 << 1)
+#define PHY_11N           (1 << 2)
+#define PHY_LR            (1 << 3)
+#define PHY_11A           (1 << 4)
+#define PHY_11AC          (1 << 5)
+#define PHY_11AX          (1 << 6)
+#define PHY_WPS           (1 << 7)
+#define PHY_FTM_RESPONDER (1 << 8)
+#define PHY_FTM_INITIATOR (1 << 9)
+
+static uint8_t* put_u16(uint8_t* buf, uint16_t value) {
+    buf[0] = value;
+    buf[1] = value >> 8;
+    return buf + 2;
+}
+
+static uint8_t* put_u32(uint8_t* buf, uint32_t value) {
+    buf = put_u16(buf, value);
+    return put_u16(buf, value >> 16);
+}
+
+static uint8_t* put_u64(uint8_t* buf, uint64_t value) {
+    buf = put_u32(buf, value);
+    return put_u32(buf, value >> 32);
+}
+
+static uint16_t get_u16(uint8_t const* buf) {
+    return buf[0] | (uint16_t)buf[1] << 8;
+}
+
+static uint32_t get_u32(uint8_t const* buf) {
+    return get_u16(buf) | (uint32_t)get_u16(buf + 2) << 16;
+}
+
+static uint64_t get_u64(uint8_t const* buf) {
+    return get_u32(buf) | (uint64_t)get_u32(buf + 4) << 32;
+}
+
+static uint16_t encode_phy(wifi_ap_record_t const* record) {
+    uint16_t phy = 0;
+    phy |= record->phy_11b ? PHY_11B : 0;
+    phy |= record->phy_11g ? PHY_11G : 0;
+    phy |= record->phy_11n ? PHY_11N : 0;
+    phy |= record->phy_lr ? PHY_LR : 0;
+    phy |= record->phy_11a ? PHY_11A : 0;
+    phy |= record->phy_11ac ? PHY_11AC : 0;
+    phy |= record->phy_11ax ? PHY_11AX : 0;
+    phy |= record->wps ? PHY_WPS : 0;
+    phy |= record->ftm_responder ? PHY_FTM_RESPONDER : 0;
+    phy |= record->ftm_initiator ? PHY_FTM_INITIATOR : 0;
+    return phy;
+}
+
+size_t scan_capture_encode_record(uint8_t* buf, wifi_ap_record_t const* record) {
+    size_t   ssid_length = strnlen((char const*)record->ssid, RECORD_SSID_MAX);
+    uint8_t* out         = buf + 1;
+    memcpy(out, record->bssid, 6);
+    out[6]  = record->primary;
+    out[7]  = record->second;
+    out[8]  = (uint8_t)record->rssi;
+    out[9]  = record->authmode;
+    out[10] = record->pairwise_cipher;
+    out[11] = record->group_cipher;
+    put_u16(out + 12, encode_phy(record));
+    out[14] = record->bandwidth;
+    out[15] = ssid_length;
+    memcpy(out + RECORD_FIXED_SIZE, record->ssid, ssid_length);
+
+    buf[0] = RECORD_FIXED_SIZE + ssid_length;
+    return buf[0] + 1;
+}
+
+static esp_err_t decode_record(uint8_t const* buf, size_t length, wifi_ap_record_t* record) {
+    if (length < RECORD_FIXED_SIZE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    size_t ssid_length = buf[15];
+    if (ssid_length > RECORD_SSID_MAX || RECORD_FIXED_SIZE + ssid_length > length) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    uint16_t phy = get_u16(buf + 12);
+
+    memset(record, 0, sizeof(*record));
+    memcpy(record->bssid, buf, 6);
+    record->primary         = buf[6];
+    record->second          = buf[7];
+    record->rssi            = (int8_t)buf[8];
+    record->authmode        = buf[9];
+    record->pairwise_cipher = buf[10];
+    record->group_cipher    = buf[11];
+    record->phy_11b         = !!(phy & PHY_11B);
+    record->phy_11g         = !!(phy & PHY_11G);
+    record->phy_11n         = !!(phy & PHY_11N);
+    record->phy_lr          = !!(phy & PHY_LR);
+    record->phy_11a         = !!(phy & PHY_11A);
+    record->phy_11ac        = !!(phy & PHY_11AC);
+    record->phy_11ax        = !!(phy & PHY_11AX);
+    record->wps             = !!(phy & PHY_WPS);
+    record->ftm_responder   = !!(phy & PHY_FTM_RESPONDER);
+    record->ftm_initiator   = !!(phy & PHY_FTM_INITIATOR);
+    record->bandwidth       = buf[14];
+    memcpy(record->ssid, buf + RECORD_FIXED_SIZE, ssid_length);
+    return ESP_OK;
+}
+
+esp_err_t scan_capture_open(scan_capture_writer_t* writer, char const* path) {
+    memset(writer, 0, sizeof(*writer));
+    writer->file = fopen(path, "wb");
+    if (writer->file == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    uint8_t header[SCAN_CAPTURE_HEADER_SIZE];
+    memcpy(header, CAPTURE_MAGIC, 4);
+    put_u16(put_u16(header + 4, SCAN_CAPTURE_VERSION), 0);
+    if (fwrite(header, sizeof(header), 1, writer->file) != 1) {
+        scan_capture_close(writer);
+        return ESP_FAIL;
+    }
+    writer->bytes = sizeof(header);
+    return ESP_OK;
+}
+
+esp_err_t scan_capture_write(scan_capture_writer_t* writer, uint32_t scan, int64_t timestamp_us,
+                             wifi_ap_record_t const* records, uint16_t count) {
+    if (writer->file == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    size_t length = SCAN_CAPTURE_FRAME_HEADER_SIZE - 4;
+    for (uint16_t i = 0; i < count; i++) {
+        length += RECORD_FIXED_SIZE + 1 + strnlen((char const*)records[i].ssid, RECORD_SSID_MAX);
+    }
+
+    uint8_t header[SCAN_CAPTURE_FRAME_HEADER_SIZE];
+    put_u16(put_u64(put_u32(put_u32(header, length), scan), timestamp_us), count);
+    bool ok = fwrite(header, sizeof(header), 1, writer->file) == 1;
+    for (uint16_t i = 0; ok && i < count; i++) {
+        uint8_t record[SCAN_CAPTURE_RECORD_MAX];
+        size_t  size = scan_capture_encode_record(record, &records[i]);
+        ok           = fwrite(record, size, 1, writer->file) == 1;
+    }
+    if (!ok) {
+        return ESP_FAIL;
+    }
+    writer->frames++;
+    writer->bytes += length + 4;
+    return ESP_OK;
+}
+
+void scan_capture_close(scan_capture_writer_t* writer) {
+    if (writer->file) {
+        fclose(writer->file);
+        writer->file = NULL;
+    }
+}
+
+esp_err_t scan_capture_reader_init(scan_capture_reader_t* reader, uint8_t const* data, size_t size) {
+    memset(reader, 0, sizeof(*reader));
+    if (size < SCAN_CAPTURE_HEADER_SIZE || memcmp(data, CAPTURE_MAGIC, 4) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    reader->version = get_u16(data + 4);
+    if (reader->version == 0 || reader->version > SCAN_CAPTURE_VERSION) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+    reader->data   = data;
+    reader->size   = size;
+    reader->offset = SCAN_CAPTURE_HEADER_SIZE;
+    return ESP_OK;
+}
+
+esp_err_t scan_capture_read_frame(scan_capture_reader_t* reader, scan_capture_frame_t* frame) {
+    size_t remaining = reader->size - reader->offset;
+    if (remaining == 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (remaining < SCAN_CAPTURE_FRAME_HEADER_SIZE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    uint8_t const* header = reader->data + reader->offset;
+    uint32_t       length = get_u32(header);
+    if (length < SCAN_CAPTURE_FRAME_HEADER_SIZE - 4 || length > remaining - 4) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    frame->scan         = get_u32(header + 4);
+    frame->timestamp_us = (int64_t)get_u64(header + 8);
+    frame->count        = get_u16(header + 16);
+    frame->records      = header + SCAN_CAPTURE_FRAME_HEADER_SIZE;
+    frame->size         = length + 4 - SCAN_CAPTURE_FRAME_HEADER_SIZE;
+    reader->offset     += length + 4;
+    return ESP_OK;
+}
+
+esp_err_t scan_capture_decode_records(scan_capture_frame_t const* frame, wifi_ap_record_t* records, uint16_t* count) {
+    size_t   offset  = 0;
+    uint16_t decoded = 0;
+    while (decoded < *count && decoded < frame->count) {
+        if (offset >= frame->size || (size_t)frame->records[offset] + 1 > frame->size - offset) {
+            *count = decoded;
+            return ESP_ERR_INVALID_SIZE;
+        }
+        size_t    length = frame->records[offset];
+        esp_err_t res    = decode_record(frame->records + offset + 1, length, &records[decoded]);
+        if (res != ESP_OK) {
+            *count = decoded;
+            return res;
+        }
+        offset += length + 1;
+        decoded++;
+    }
+    *count = decoded;
+    return ESP_OK;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "esp_err.h"
+#include "esp_wifi_types.h"
+
+// Binary capture of scan results, all integers little endian:
+//
+//   header  "WSCP", u16 version, u16 reserved
+//   frame   u32 length of the rest of the frame, u32 scan, i64 timestamp_us, u16 count,
+//           then count records, each a u8 length followed by the encoded record
+//
+// A scan fetched in chunks is stored as consecutive frames with the same scan number. Frames
+// and records are length-prefixed, so readers skip fields added by later versions.
+#define SCAN_CAPTURE_VERSION           1
+#define SCAN_CAPTURE_HEADER_SIZE       8
+#define SCAN_CAPTURE_FRAME_HEADER_SIZE 18
+#define SCAN_CAPTURE_RECORD_MAX        49  // Length byte plus the longest encoded record
+
+// Encode into buf, which must hold SCAN_CAPTURE_RECORD_MAX bytes. Returns the bytes written.
+size_t scan_capture_encode_record(uint8_t* buf, wifi_ap_record_t const* record);
+
+typedef struct {
+    FILE*    file;
+    uint32_t frames;
+    uint64_t bytes;
+} scan_capture_writer_t;
+
+esp_err_t scan_capture_open(scan_capture_writer_t* writer, char const* path);
+esp_err_t scan_capture_write(scan_capture_writer_t* writer, uint32_t scan, int64_t timestamp_us,
+                             wifi_ap_record_t const* records, uint16_t count);
+void      scan_capture_close(scan_capture_writer_t* writer);
+
+typedef struct {
+    uint32_t       scan;
+    int64_t        timestamp_us;
+    uint16_t       count;
+    uint8_t const* records;  // Encoded records
+    size_t         size;
+} scan_capture_frame_t;
+
+// Walks a capture held in memory without copying it
+typedef struct {
+    uint8_t const* data;
+    size_t         size;
+    size_t         offset;
+    uint16_t       version;
+} scan_capture_reader_t;
+
+esp_err_t scan_capture_reader_init(scan_capture_reader_t* reader, uint8_t const* data, size_t size);
+
+// ESP_ERR_NOT_FOUND at the end of the capture, ESP_ERR_INVALID_SIZE when it is truncated
+esp_err_t scan_capture_read_frame(scan_capture_reader_t* reader, scan_capture_frame_t* frame);
+
+// Decode up to *count records of the frame, *count is set to the number decoded
+esp_err_t scan_capture_decode_records(scan_capture_frame_t const* frame, wifi_ap_record_t* records, uint16_t* count);
@@ -0,0 +1,101 @@
+#include "scan_scheduler.h"
+#include <string.h>
+
+#define DENSITY_SHIFT     4
+#define DENSITY_BUSY      (3 << DENSITY_SHIFT)  // Three or more APs per visit on average
+#define MAX_BACKOFF_SHIFT 3                     // Empty channels are still visited every 8 sweeps
+
+#define BUSY_DWELL_MIN_MS  40
+#define BUSY_DWELL_MAX_MS  120
+#define QUIET_DWELL_MIN_MS 10
+#define QUIET_DWELL_MAX_MS 40
+
+void scan_scheduler_init(scan_scheduler_t* sched, uint16_t allowed_channels) {
+    memset(sched, 0, sizeof(*sched));
+    sched->allowed = allowed_channels & (((1 << (SCAN_SCHEDULER_CHANNELS + 1)) - 1) & ~1);
+}
+
+static bool scheduler_channel_due(scan_scheduler_t const* sched, uint8_t channel) {
+    uint8_t empty = sched->empty_visits[channel];
+    if (empty == 0) {
+        return true;
+    }
+    if (empty > MAX_BACKOFF_SHIFT) {
+        empty = MAX_BACKOFF_SHIFT;
+    }
+    return sched->skipped[channel] + 1 >= (1 << empty);
+}
+
+void scan_scheduler_plan(scan_scheduler_t* sched, scan_plan_t* plan) {
+    scan_step_t* busy  = &plan->steps[0];
+    scan_step_t* quiet = &plan->steps[1];
+    memset(plan, 0, sizeof(*plan));
+
+    for (uint8_t channel = 1; channel <= SCAN_SCHEDULER_CHANNELS; channel++) {
+        uint16_t bit = 1 << channel;
+        if (!(sched->allowed & bit)) {
+            continue;
+        }
+        if (!(sched->visited & bit) || sched->density[channel] >= DENSITY_BUSY) {
+            busy->channels |= bit;
+        } else if (scheduler_channel_due(sched, channel)) {
+            quiet->channels |= bit;
+        } else {
+            sched->skipped[channel]++;
+            continue;
+        }
+        sched->skipped[channel] = 0;
+    }
+
+    busy->type         = WIFI_SCAN_TYPE_ACTIVE;
+    busy->dwell_min_ms = BUSY_DWELL_MIN_MS;
+    busy->dwell_max_ms = BUSY_DWELL_MAX_MS;
+
+    quiet->type         = WIFI_SCAN_TYPE_ACTIVE;
+    quiet->dwell_min_ms = QUIET_DWELL_MIN_MS;
+    quiet->dwell_max_ms = QUIET_DWELL_MAX_MS;
+
+    // Drop empty steps
+    if (busy->channels == 0) {
+        *busy = *quiet;
+        memset(quiet, 0, sizeof(*quiet));
+    }
+    plan->count = (busy->channels ? 1 : 0) + (quiet->channels ? 1 : 0);
+    sched->sweeps++;
+}
+
+void scan_scheduler_config(scan_step_t const* step, wifi_scan_config_t* config) {
+    memset(config, 0, sizeof(*config));
+    config->scan_type                     = step->type;
+    config->channel_bitmap.ghz_2_channels = step->channels;
+    if (step->type == WIFI_SCAN_TYPE_ACTIVE) {
+        config->scan_time.active.min = step->dwell_min_ms;
+        config->scan_time.active.max = step->dwell_max_ms;
+    } else {
+        config->scan_time.passive = step->dwell_max_ms;
+    }
+}
+
+void scan_scheduler_observe(scan_scheduler_t* sched, uint16_t channels, uint16_t const* channel_counts) {
+    for (uint8_t channel = 1; channel <= SCAN_SCHEDULER_CHANNELS; channel++) {
+        uint16_t bit = 1 << channel;
+        if (!(channels & bit)) {
+            continue;
+        }
+        int32_t sample = (int32_t)channel_counts[channel] << DENSITY_SHIFT;
+        if (sched->visited & bit) {
+            int32_t density          = sched->density[channel];
+            sched->density[channel] = (uint16_t)(density + (sample - density) / 4);
+        } else {
+            sched->density[channel] = (uint16_t)sample;
+            sched->visited |= bit;
+        }
+        if (channel_counts[channel] == 0) {
+            if (sched->empty_visits[channel] < UINT8_MAX) {
+                sched->empty_visits[channel]++;
+            }
+        } else {
+            sched->empty_visits[channel] = 0;
+        }
+    }
+}
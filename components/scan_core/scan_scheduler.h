@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_wifi_types.h"
+
+#define SCAN_SCHEDULER_CHANNELS  14  // 2.4 GHz channels 1 to 14, bit n of a channel mask is channel n
+#define SCAN_SCHEDULER_MAX_STEPS 2
+
+// One esp_wifi_scan_start() call covering a set of channels with the same dwell time
+typedef struct {
+    uint16_t         channels;
+    wifi_scan_type_t type;
+    uint16_t         dwell_min_ms;
+    uint16_t         dwell_max_ms;
+} scan_step_t;
+
+typedef struct {
+    uint8_t     count;
+    scan_step_t steps[SCAN_SCHEDULER_MAX_STEPS];
+} scan_plan_t;
+
+// Per-channel AP density history used to decide which channels to visit and for how long
+typedef struct {
+    uint16_t allowed;                                   // Channels that may be scanned
+    uint16_t density[SCAN_SCHEDULER_CHANNELS + 1];      // EWMA of APs per visit, 4 fractional bits
+    uint8_t  empty_visits[SCAN_SCHEDULER_CHANNELS + 1]; // Consecutive visits without any AP
+    uint8_t  skipped[SCAN_SCHEDULER_CHANNELS + 1];      // Sweeps since the channel was last visited
+    uint16_t visited;                                   // Channels with any history
+    uint32_t sweeps;
+} scan_scheduler_t;
+
+void scan_scheduler_init(scan_scheduler_t* sched, uint16_t allowed_channels);
+
+// Plan the next sweep. Busy and unknown channels get a long active dwell every sweep,
+// quiet ones a short dwell, and channels that keep coming up empty are visited less often.
+void scan_scheduler_plan(scan_scheduler_t* sched, scan_plan_t* plan);
+
+void scan_scheduler_config(scan_step_t const* step, wifi_scan_config_t* config);
+
+// Feed back the number of APs found per channel by a step covering `channels`
+void scan_scheduler_observe(scan_scheduler_t* sched, uint16_t channels, uint16_t const* channel_counts);
@@ -0,0 +1,12 @@
+#pragma once
+
+// Host stand-in for esp_timer.h, microseconds of the monotonic clock
+
+#include <stdint.h>
+#include <time.h>
+
+static inline int64_t esp_timer_get_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+// Host stand-in for the station and scan parts of esp_wifi.h. The records "held by the radio"
+// are synthetic and set up through wifi_stub.h, so the scan pipeline can run without hardware.
+// Every call takes the latency configured with wifi_stub_set_latency(), to mock the RPC round
+// trip to the radio co-processor.
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_wifi_types.h"
+
+// Contents are ignored by the stub
+typedef struct {
+    int magic;
+} wifi_init_config_t;
+
+#define WIFI_INIT_CONFIG_DEFAULT() {.magic = 0x1F2F3F4F}
+
+esp_err_t esp_wifi_init(wifi_init_config_t const* config);
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode);
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t* conf);
+esp_err_t esp_wifi_start(void);
+esp_err_t esp_wifi_stop(void);
+
+// Only checks the state, the result list is whatever wifi_stub set up
+esp_err_t esp_wifi_scan_start(wifi_scan_config_t const* config, bool block);
+esp_err_t esp_wifi_scan_stop(void);
+
+esp_err_t esp_wifi_scan_get_ap_num(uint16_t* number);
+
+// Copies up to *number records and frees the whole list, like the driver does
+esp_err_t esp_wifi_scan_get_ap_records(uint16_t* number, wifi_ap_record_t* ap_records);
+
+// Pops the next record, ESP_FAIL once the list is empty
+esp_err_t esp_wifi_scan_get_ap_record(wifi_ap_record_t* ap_record);
+
+esp_err_t esp_wifi_clear_ap_list(void);
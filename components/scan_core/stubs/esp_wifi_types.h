@@ -0,0 +1,168 @@
+#pragma once
+
+// Host stand-in for the ESP-IDF WiFi type definitions, limited to what the scan
+// processing code uses. Names and enum order follow esp_wifi_types_generic.h.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+    WIFI_AUTH_OPEN = 0,
+    WIFI_AUTH_WEP,
+    WIFI_AUTH_WPA_PSK,
+    WIFI_AUTH_WPA2_PSK,
+    WIFI_AUTH_WPA_WPA2_PSK,
+    WIFI_AUTH_ENTERPRISE,
+    WIFI_AUTH_WPA2_ENTERPRISE = WIFI_AUTH_ENTERPRISE,
+    WIFI_AUTH_WPA3_PSK,
+    WIFI_AUTH_WPA2_WPA3_PSK,
+    WIFI_AUTH_WAPI_PSK,
+    WIFI_AUTH_OWE,
+    WIFI_AUTH_WPA3_ENT_192,
+    WIFI_AUTH_WPA3_EXT_PSK,
+    WIFI_AUTH_WPA3_EXT_PSK_MIXED_MODE,
+    WIFI_AUTH_DPP,
+    WIFI_AUTH_WPA3_ENTERPRISE,
+    WIFI_AUTH_WPA2_WPA3_ENTERPRISE,
+    WIFI_AUTH_MAX
+} wifi_auth_mode_t;
+
+typedef enum {
+    WIFI_CIPHER_TYPE_NONE = 0,
+    WIFI_CIPHER_TYPE_WEP40,
+    WIFI_CIPHER_TYPE_WEP104,
+    WIFI_CIPHER_TYPE_TKIP,
+    WIFI_CIPHER_TYPE_CCMP,
+    WIFI_CIPHER_TYPE_TKIP_CCMP,
+    WIFI_CIPHER_TYPE_AES_CMAC128,
+    WIFI_CIPHER_TYPE_SMS4,
+    WIFI_CIPHER_TYPE_GCMP,
+    WIFI_CIPHER_TYPE_GCMP256,
+    WIFI_CIPHER_TYPE_AES_GMAC128,
+    WIFI_CIPHER_TYPE_AES_GMAC256,
+    WIFI_CIPHER_TYPE_UNKNOWN,
+} wifi_cipher_type_t;
+
+typedef enum {
+    WIFI_SECOND_CHAN_NONE = 0,
+    WIFI_SECOND_CHAN_ABOVE,
+    WIFI_SECOND_CHAN_BELOW,
+} wifi_second_chan_t;
+
+typedef enum {
+    WIFI_ANT_ANT0,
+    WIFI_ANT_ANT1,
+    WIFI_ANT_MAX,
+} wifi_ant_t;
+
+typedef enum {
+    WIFI_MODE_NULL = 0,
+    WIFI_MODE_STA,
+    WIFI_MODE_AP,
+    WIFI_MODE_APSTA,
+    WIFI_MODE_NAN,
+    WIFI_MODE_MAX,
+} wifi_mode_t;
+
+typedef enum {
+    WIFI_IF_STA,
+    WIFI_IF_AP,
+} wifi_interface_t;
+
+typedef enum {
+    WIFI_SCAN_TYPE_ACTIVE = 0,
+    WIFI_SCAN_TYPE_PASSIVE,
+} wifi_scan_type_t;
+
+typedef struct {
+    uint32_t min;
+    uint32_t max;
+} wifi_active_scan_time_t;
+
+typedef struct {
+    wifi_active_scan_time_t active;
+    uint32_t                passive;
+} wifi_scan_time_t;
+
+typedef struct {
+    uint16_t ghz_2_channels;
+    uint32_t ghz_5_channels;
+} wifi_scan_channel_bitmap_t;
+
+typedef struct {
+    uint8_t*                   ssid;
+    uint8_t*                   bssid;
+    uint8_t                    channel;
+    bool                       show_hidden;
+    wifi_scan_type_t           scan_type;
+    wifi_scan_time_t           scan_time;
+    uint8_t                    home_chan_dwell_time;
+    wifi_scan_channel_bitmap_t channel_bitmap;
+} wifi_scan_config_t;
+
+typedef struct {
+    char    cc[3];
+    uint8_t schan;
+    uint8_t nchan;
+    int8_t  max_tx_power;
+    int     policy;
+} wifi_country_t;
+
+typedef struct {
+    uint8_t            bssid[6];
+    uint8_t            ssid[33];
+    uint8_t            primary;
+    wifi_second_chan_t second;
+    int8_t             rssi;
+    wifi_auth_mode_t   authmode;
+    wifi_cipher_type_t pairwise_cipher;
+    wifi_cipher_type_t group_cipher;
+    wifi_ant_t         ant;
+    uint32_t           phy_11b       : 1;
+    uint32_t           phy_11g       : 1;
+    uint32_t           phy_11n       : 1;
+    uint32_t           phy_lr        : 1;
+    uint32_t           phy_11a       : 1;
+    uint32_t           phy_11ac      : 1;
+    uint32_t           phy_11ax      : 1;
+    uint32_t           wps           : 1;
+    uint32_t           ftm_responder : 1;
+    uint32_t           ftm_initiator : 1;
+    uint32_t           reserved      : 22;
+    wifi_country_t     country;
+    uint8_t            he_ap[4];
+    uint8_t            bandwidth;
+    uint8_t            vht_ch_freq1;
+    uint8_t            vht_ch_freq2;
+} wifi_ap_record_t;
+
+typedef enum {
+    WIFI_FAST_SCAN = 0,
+    WIFI_ALL_CHANNEL_SCAN,
+} wifi_scan_method_t;
+
+typedef enum {
+    WIFI_CONNECT_AP_BY_SIGNAL = 0,
+    WIFI_CONNECT_AP_BY_SECURITY,
+} wifi_sort_method_t;
+
+typedef struct {
+    int8_t           rssi;
+    wifi_auth_mode_t authmode;
+} wifi_scan_threshold_t;
+
+// Only the station fields the application sets, the layout does not match the driver
+typedef struct {
+    uint8_t               ssid[32];
+    uint8_t               password[64];
+    wifi_scan_method_t    scan_method;
+    bool                  bssid_set;
+    uint8_t               bssid[6];
+    uint8_t               channel;
+    wifi_sort_method_t    sort_method;
+    wifi_scan_threshold_t threshold;
+} wifi_sta_config_t;
+
+typedef union {
+    wifi_sta_config_t sta;
+} wifi_config_t;
@@ -0,0 +1,143 @@
+#include "scan_replay.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "wifi_stub.h"
+
+static int64_t replay_clock_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void replay_wait_until(int64_t deadline_us) {
+    int64_t wait_us = deadline_us - replay_clock_us();
+    if (wait_us <= 0) {
+        return;
+    }
+    struct timespec ts = {.tv_sec = wait_us / 1000000, .tv_nsec = (wait_us % 1000000) * 1000};
+    nanosleep(&ts, NULL);
+}
+
+static esp_err_t replay_reserve(scan_replay_t* replay, uint32_t count) {
+    if (count <= replay->capacity) {
+        return ESP_OK;
+    }
+    uint32_t capacity = replay->capacity ? replay->capacity : 64;
+    while (capacity < count) {
+        capacity *= 2;
+    }
+    wifi_ap_record_t* records = realloc(replay->records, sizeof(wifi_ap_record_t) * capacity);
+    if (records == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    replay->records  = records;
+    replay->capacity = capacity;
+    return ESP_OK;
+}
+
+esp_err_t scan_replay_open(scan_replay_t* replay, char const* path, bool realtime) {
+    memset(replay, 0, sizeof(*replay));
+    replay->realtime = realtime;
+
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    esp_err_t res = ESP_OK;
+    if (fseek(file, 0, SEEK_END) == 0) {
+        long size = ftell(file);
+        rewind(file);
+        replay->data = size > 0 ? malloc(size) : NULL;
+        replay->size = size > 0 ? size : 0;
+    }
+    if (replay->data == NULL) {
+        res = ESP_ERR_NO_MEM;
+    } else if (fread(replay->data, replay->size, 1, file) != 1) {
+        res = ESP_FAIL;
+    }
+    fclose(file);
+
+    if (res == ESP_OK) {
+        res = scan_capture_reader_init(&replay->reader, replay->data, replay->size);
+    }
+    if (res != ESP_OK) {
+        scan_replay_close(replay);
+    }
+    return res;
+}
+
+esp_err_t scan_replay_next(scan_replay_t* replay, int64_t* timestamp_us, uint16_t* count) {
+    scan_capture_frame_t frame;
+    if (replay->has_pending) {
+        frame               = replay->pending;
+        replay->has_pending = false;
+    } else {
+        esp_err_t res = scan_capture_read_frame(&replay->reader, &frame);
+        if (res != ESP_OK) {
+            return res;
+        }
+    }
+
+    // Collect the frames of this scan, the first frame of the next one is kept for later
+    int64_t  timestamp = frame.timestamp_us;
+    uint32_t total     = 0;
+    while (1) {
+        esp_err_t res = replay_reserve(replay, total + frame.count);
+        if (res != ESP_OK) {
+            return res;
+        }
+        uint16_t decoded = frame.count;
+        res              = scan_capture_decode_records(&frame, &replay->records[total], &decoded);
+        if (res != ESP_OK) {
+            return res;
+        }
+        total += decoded;
+
+        scan_capture_frame_t next;
+        res = scan_capture_read_frame(&replay->reader, &next);
+        if (res == ESP_ERR_NOT_FOUND) {
+            break;
+        }
+        if (res != ESP_OK) {
+            return res;  // Truncated capture
+        }
+        if (next.scan != frame.scan) {
+            replay->pending     = next;
+            replay->has_pending = true;
+            break;
+        }
+        frame = next;
+    }
+    if (total > UINT16_MAX) {
+        total = UINT16_MAX;
+    }
+
+    if (replay->scans == 0) {
+        replay->first_us = timestamp;
+        replay->start_us = replay_clock_us();
+    } else if (replay->realtime) {
+        replay_wait_until(replay->start_us + timestamp - replay->first_us);
+    }
+    replay->scans++;
+
+    if (timestamp_us) {
+        *timestamp_us = timestamp;
+    }
+    if (count) {
+        *count = total;
+    }
+    return wifi_stub_set_records(replay->records, total);
+}
+
+void scan_replay_rewind(scan_replay_t* replay) {
+    scan_capture_reader_init(&replay->reader, replay->data, replay->size);
+    replay->has_pending = false;
+    replay->scans       = 0;
+}
+
+void scan_replay_close(scan_replay_t* replay) {
+    free(replay->data);
+    free(replay->records);
+    memset(replay, 0, sizeof(*replay));
+}
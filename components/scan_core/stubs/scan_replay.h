@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_wifi_types.h"
+#include "scan_capture.h"
+
+// Feeds a capture written by scan_capture_write() back through the stub scan API: every call
+// to scan_replay_next() makes the next captured scan the list esp_wifi_scan_get_ap_num() and
+// friends report, as if the radio had just finished it.
+typedef struct {
+    uint8_t*              data;
+    size_t                size;
+    scan_capture_reader_t reader;
+    scan_capture_frame_t  pending;  // First frame of the next scan, read ahead
+    bool                  has_pending;
+    wifi_ap_record_t*     records;
+    uint32_t              capacity;
+    bool                  realtime;
+    int64_t               first_us;  // Capture timestamp of the first scan replayed
+    int64_t               start_us;  // Host clock when the first scan was replayed
+    uint32_t              scans;
+} scan_replay_t;
+
+// With realtime set, scans are handed out at the pace they were captured at, otherwise as
+// fast as they are asked for
+esp_err_t scan_replay_open(scan_replay_t* replay, char const* path, bool realtime);
+
+// ESP_ERR_NOT_FOUND once every scan has been replayed
+esp_err_t scan_replay_next(scan_replay_t* replay, int64_t* timestamp_us, uint16_t* count);
+
+// Start over from the first scan
+void scan_replay_rewind(scan_replay_t* replay);
+void scan_replay_close(scan_replay_t* replay);
@@ -0,0 +1,230 @@
+#include "wifi_stub.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "esp_wifi.h"
+
+static wifi_ap_record_t* stub_records  = NULL;
+static uint16_t          stub_capacity = 0;
+static uint16_t          stub_count    = 0;
+static uint16_t          stub_next     = 0;  // Next record esp_wifi_scan_get_ap_record() pops
+
+static wifi_stub_latency_t stub_latency = {0};
+static uint32_t            stub_rng     = 1;
+static bool                stub_inited  = false;
+static bool                stub_started = false;
+
+static uint32_t stub_hash(uint32_t value) {
+    value ^= value >> 16;
+    value *= 0x7feb352d;
+    value ^= value >> 15;
+    value *= 0x846ca68b;
+    value ^= value >> 16;
+    return value;
+}
+
+// Sleep for the mocked round trip of a call moving `bytes` of arguments and results
+static void stub_rpc(size_t bytes) {
+    uint64_t us = stub_latency.base_us + (uint64_t)stub_latency.per_kib_us * bytes / 1024;
+    if (stub_latency.jitter_us) {
+        stub_rng = stub_hash(stub_rng);
+        us += stub_rng % (stub_latency.jitter_us + 1);
+    }
+    if (us == 0) {
+        return;
+    }
+    struct timespec ts = {.tv_sec = us / 1000000, .tv_nsec = (us % 1000000) * 1000};
+    nanosleep(&ts, NULL);
+}
+
+static void stub_clear(void) {
+    // The storage stays around for the next scan, only the list is emptied
+    stub_count = 0;
+    stub_next  = 0;
+}
+
+static esp_err_t stub_reserve(uint16_t count) {
+    if (count <= stub_capacity) {
+        return ESP_OK;
+    }
+    wifi_ap_record_t* records = realloc(stub_records, sizeof(wifi_ap_record_t) * count);
+    if (records == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    stub_records  = records;
+    stub_capacity = count;
+    return ESP_OK;
+}
+
+static void stub_fill(wifi_ap_record_t* record, uint32_t index, uint32_t seed) {
+    static wifi_auth_mode_t const   modes[]   = {WIFI_AUTH_OPEN, WIFI_AUTH_WPA2_PSK, WIFI_AUTH_WPA_WPA2_PSK,
+                                                 WIFI_AUTH_WPA2_WPA3_PSK, WIFI_AUTH_ENTERPRISE, WIFI_AUTH_WPA3_PSK};
+    static wifi_cipher_type_t const ciphers[] = {WIFI_CIPHER_TYPE_CCMP, WIFI_CIPHER_TYPE_TKIP_CCMP,
+                                                 WIFI_CIPHER_TYPE_TKIP};
+    uint32_t identity = stub_hash(index + 1);
+    uint32_t sample   = stub_hash(identity ^ seed);
+
+    memset(record, 0, sizeof(*record));
+    record->bssid[0] = 0x02;  // Locally administered
+    record->bssid[1] = index >> 24;
+    record->bssid[2] = index >> 16;
+    record->bssid[3] = index >> 8;
+    record->bssid[4] = index;
+    record->bssid[5] = identity;
+    snprintf((char*)record->ssid, sizeof(record->ssid), "venue-net-%u", (unsigned)(identity % 500));
+    record->primary         = 1 + identity % 13;
+    record->rssi            = -30 - (int)((identity >> 8) % 60) - (int)(sample % 6);
+    record->authmode        = modes[(identity >> 12) % (sizeof(modes) / sizeof(modes[0]))];
+    record->pairwise_cipher = ciphers[(identity >> 16) % (sizeof(ciphers) / sizeof(ciphers[0]))];
+    record->group_cipher    = ciphers[(identity >> 20) % (sizeof(ciphers) / sizeof(ciphers[0]))];
+    record->phy_11b         = 1;
+    record->phy_11g         = 1;
+    record->phy_11n         = (identity >> 24) & 1;
+    record->phy_11ax        = (identity >> 25) % 4 == 0;
+}
+
+esp_err_t wifi_stub_generate(uint16_t count, uint32_t seed) {
+    esp_err_t res = stub_reserve(count);
+    if (res != ESP_OK) {
+        return res;
+    }
+    for (uint16_t i = 0; i < count; i++) {
+        stub_fill(&stub_records[i], i, seed);
+    }
+    // Shuffle, the driver reports APs in the order they were heard
+    uint32_t state = seed | 1;
+    for (uint16_t i = count; i > 1; i--) {
+        state                = stub_hash(state);
+        uint16_t         j   = state % i;
+        wifi_ap_record_t tmp = stub_records[i - 1];
+        stub_records[i - 1]  = stub_records[j];
+        stub_records[j]      = tmp;
+    }
+    stub_count = count;
+    stub_next  = 0;
+    return ESP_OK;
+}
+
+esp_err_t wifi_stub_set_records(wifi_ap_record_t const* records, uint16_t count) {
+    esp_err_t res = stub_reserve(count);
+    if (res != ESP_OK) {
+        return res;
+    }
+    if (count > 0) {
+        memcpy(stub_records, records, sizeof(wifi_ap_record_t) * count);
+    }
+    stub_count = count;
+    stub_next  = 0;
+    return ESP_OK;
+}
+
+void wifi_stub_reset(void) {
+    free(stub_records);
+    stub_records  = NULL;
+    stub_capacity = 0;
+    stub_count    = 0;
+    stub_next     = 0;
+    stub_inited   = false;
+    stub_started  = false;
+}
+
+void wifi_stub_set_latency(wifi_stub_latency_t const* latency) {
+    stub_latency = *latency;
+}
+
+esp_err_t esp_wifi_init(wifi_init_config_t const* config) {
+    stub_rpc(sizeof(*config));
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    stub_inited = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode) {
+    stub_rpc(sizeof(mode));
+    if (!stub_inited) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return mode < WIFI_MODE_MAX ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t* conf) {
+    stub_rpc(sizeof(*conf));
+    if (!stub_inited) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return conf && interface == WIFI_IF_STA ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t esp_wifi_start(void) {
+    stub_rpc(0);
+    if (!stub_inited) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    stub_started = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_stop(void) {
+    stub_rpc(0);
+    stub_started = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_scan_start(wifi_scan_config_t const* config, bool block) {
+    (void)block;
+    stub_rpc(config ? sizeof(*config) : 0);
+    if (!stub_started) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    // The result list is ready at once, so the scan is over even when not blocking
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_scan_stop(void) {
+    stub_rpc(0);
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_scan_get_ap_num(uint16_t* number) {
+    stub_rpc(sizeof(*number));
+    if (number == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *number = stub_count - stub_next;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_scan_get_ap_records(uint16_t* number, wifi_ap_record_t* ap_records) {
+    if (number == NULL || ap_records == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint16_t available = stub_count - stub_next;
+    if (*number > available) {
+        *number = available;
+    }
+    stub_rpc(sizeof(wifi_ap_record_t) * *number);
+    memcpy(ap_records, &stub_records[stub_next], sizeof(wifi_ap_record_t) * *number);
+    stub_clear();
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_scan_get_ap_record(wifi_ap_record_t* ap_record) {
+    stub_rpc(sizeof(*ap_record));
+    if (ap_record == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (stub_next == stub_count) {
+        return ESP_FAIL;
+    }
+    *ap_record = stub_records[stub_next++];
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_clear_ap_list(void) {
+    stub_rpc(0);
+    stub_clear();
+    return ESP_OK;
+}
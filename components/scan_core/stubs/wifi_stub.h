@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_wifi_types.h"
+
+// Replace the scan result list with `count` synthetic records. BSSIDs, SSIDs and channels only
+// depend on the index, so consecutive scans report the same APs; `seed` varies the RSSI and
+// the order the records come back in, the way repeated scans of a venue do.
+esp_err_t wifi_stub_generate(uint16_t count, uint32_t seed);
+
+// Replace the scan result list with a copy of the given records
+esp_err_t wifi_stub_set_records(wifi_ap_record_t const* records, uint16_t count);
+
+// Release the list and its storage
+void wifi_stub_reset(void);
+
+// Mocked round trip of every esp_wifi call: base plus a uniformly random share of jitter, plus
+// the transfer time of the arguments and results. All zero (the default) returns immediately.
+typedef struct {
+    uint32_t base_us;
+    uint32_t jitter_us;
+    uint32_t per_kib_us;
+} wifi_stub_latency_t;
+
+void wifi_stub_set_latency(wifi_stub_latency_t const* latency);
@@ -0,0 +1,188 @@
+#include "wifi_rpc.h"
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include "esp_timer.h"
+
+typedef struct {
+    atomic_uint_least32_t calls;
+    atomic_uint_least32_t failures;
+    atomic_uint_least64_t bytes;
+    atomic_uint_least64_t total_us;
+    atomic_uint_least32_t max_us;
+    atomic_uint_least32_t buckets[WIFI_RPC_BUCKETS];
+} rpc_counters_t;
+
+static char const* const rpc_names[WIFI_RPC_CALL_COUNT] = {
+    [WIFI_RPC_INIT]                = "init",
+    [WIFI_RPC_SET_MODE]            = "set_mode",
+    [WIFI_RPC_SET_CONFIG]          = "set_config",
+    [WIFI_RPC_START]               = "start",
+    [WIFI_RPC_STOP]                = "stop",
+    [WIFI_RPC_SCAN_START]          = "scan_start",
+    [WIFI_RPC_SCAN_STOP]           = "scan_stop",
+    [WIFI_RPC_SCAN_GET_AP_NUM]     = "scan_get_ap_num",
+    [WIFI_RPC_SCAN_GET_AP_RECORDS] = "scan_get_ap_records",
+    [WIFI_RPC_SCAN_GET_AP_RECORD]  = "scan_get_ap_record",
+    [WIFI_RPC_CLEAR_AP_LIST]       = "clear_ap_list",
+};
+
+static rpc_counters_t counters[WIFI_RPC_CALL_COUNT];
+
+static uint8_t rpc_bucket(uint32_t us) {
+    uint8_t bucket = 0;
+    while (us != 0 && bucket < WIFI_RPC_BUCKETS - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+static esp_err_t rpc_record(wifi_rpc_call_t call, int64_t start_us, esp_err_t res, size_t bytes) {
+    int64_t         elapsed = esp_timer_get_time() - start_us;
+    uint32_t        us      = elapsed > UINT32_MAX ? UINT32_MAX : (uint32_t)elapsed;
+    rpc_counters_t* counter = &counters[call];
+
+    atomic_fetch_add_explicit(&counter->calls, 1, memory_order_relaxed);
+    if (res != ESP_OK) {
+        atomic_fetch_add_explicit(&counter->failures, 1, memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&counter->bytes, bytes, memory_order_relaxed);
+    atomic_fetch_add_explicit(&counter->total_us, us, memory_order_relaxed);
+    atomic_fetch_add_explicit(&counter->buckets[rpc_bucket(us)], 1, memory_order_relaxed);
+    uint32_t max = atomic_load_explicit(&counter->max_us, memory_order_relaxed);
+    while (us > max && !atomic_compare_exchange_weak_explicit(&counter->max_us, &max, us, memory_order_relaxed,
+                                                              memory_order_relaxed)) {
+    }
+    return res;
+}
+
+esp_err_t wifi_rpc_init(wifi_init_config_t const* config) {
+    int64_t start = esp_timer_get_time();
+    return rpc_record(WIFI_RPC_INIT, start, esp_wifi_init(config), sizeof(*config));
+}
+
+esp_err_t wifi_rpc_set_mode(wifi_mode_t mode) {
+    int64_t start = esp_timer_get_time();
+    return rpc_record(WIFI_RPC_SET_MODE, start, esp_wifi_set_mode(mode), sizeof(mode));
+}
+
+esp_err_t wifi_rpc_set_config(wifi_interface_t interface, wifi_config_t* config) {
+    int64_t start = esp_timer_get_time();
+    return rpc_record(WIFI_RPC_SET_CONFIG, start, esp_wifi_set_config(interface, config), sizeof(*config));
+}
+
+esp_err_t wifi_rpc_start(void) {
+    int64_t start = esp_timer_get_time();
+    return rpc_record(WIFI_RPC_START, start, esp_wifi_start(), 0);
+}
+
+esp_err_t wifi_rpc_stop(void) {
+    int64_t start = esp_timer_get_time();
+    return rpc_record(WIFI_RPC_STOP, start, esp_wifi_stop(), 0);
+}
+
+esp_err_t wifi_rpc_scan_start(wifi_scan_config_t const* config, bool block) {
+    int64_t start = esp_timer_get_time();
+    return rpc_record(WIFI_RPC_SCAN_START, start, esp_wifi_scan_start(config, block),
+                      config ? sizeof(*config) : 0);
+}
+
+esp_err_t wifi_rpc_scan_stop(void) {
+    int64_t start = esp_timer_get_time();
+    return rpc_record(WIFI_RPC_SCAN_STOP, start, esp_wifi_scan_stop(), 0);
+}
+
+esp_err_t wifi_rpc_scan_get_ap_num(uint16_t* number) {
+    int64_t start = esp_timer_get_time();
+    return rpc_record(WIFI_RPC_SCAN_GET_AP_NUM, start, esp_wifi_scan_get_ap_num(number), sizeof(*number));
+}
+
+esp_err_t wifi_rpc_scan_get_ap_records(uint16_t* number, wifi_ap_record_t* records) {
+    int64_t   start = esp_timer_get_time();
+    esp_err_t res   = esp_wifi_scan_get_ap_records(number, records);
+    size_t    bytes = sizeof(*number) + (res == ESP_OK ? sizeof(*records) * *number : 0);
+    return rpc_record(WIFI_RPC_SCAN_GET_AP_RECORDS, start, res, bytes);
+}
+
+esp_err_t wifi_rpc_scan_get_ap_record(wifi_ap_record_t* record) {
+    int64_t   start = esp_timer_get_time();
+    esp_err_t res   = esp_wifi_scan_get_ap_record(record);
+    return rpc_record(WIFI_RPC_SCAN_GET_AP_RECORD, start, res, res == ESP_OK ? sizeof(*record) : 0);
+}
+
+esp_err_t wifi_rpc_clear_ap_list(void) {
+    int64_t start = esp_timer_get_time();
+    return rpc_record(WIFI_RPC_CLEAR_AP_LIST, start, esp_wifi_clear_ap_list(), 0);
+}
+
+char const* wifi_rpc_name(wifi_rpc_call_t call) {
+    return call < WIFI_RPC_CALL_COUNT ? rpc_names[call] : "unknown";
+}
+
+void wifi_rpc_get_stats(wifi_rpc_call_t call, wifi_rpc_stats_t* out) {
+    rpc_counters_t* counter = &counters[call];
+    out->calls              = atomic_load_explicit(&counter->calls, memory_order_relaxed);
+    out->failures           = atomic_load_explicit(&counter->failures, memory_order_relaxed);
+    out->bytes              = atomic_load_explicit(&counter->bytes, memory_order_relaxed);
+    out->total_us           = atomic_load_explicit(&counter->total_us, memory_order_relaxed);
+    out->max_us             = atomic_load_explicit(&counter->max_us, memory_order_relaxed);
+    for (uint8_t i = 0; i < WIFI_RPC_BUCKETS; i++) {
+        out->buckets[i] = atomic_load_explicit(&counter->buckets[i], memory_order_relaxed);
+    }
+}
+
+void wifi_rpc_reset_stats(void) {
+    for (uint8_t call = 0; call < WIFI_RPC_CALL_COUNT; call++) {
+        rpc_counters_t* counter = &counters[call];
+        atomic_store_explicit(&counter->calls, 0, memory_order_relaxed);
+        atomic_store_explicit(&counter->failures, 0, memory_order_relaxed);
+        atomic_store_explicit(&counter->bytes, 0, memory_order_relaxed);
+        atomic_store_explicit(&counter->total_us, 0, memory_order_relaxed);
+        atomic_store_explicit(&counter->max_us, 0, memory_order_relaxed);
+        for (uint8_t i = 0; i < WIFI_RPC_BUCKETS; i++) {
+            atomic_store_explicit(&counter->buckets[i], 0, memory_order_relaxed);
+        }
+    }
+}
+
+uint32_t wifi_rpc_percentile_us(wifi_rpc_stats_t const* stats, uint8_t percentile) {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < WIFI_RPC_BUCKETS; i++) {
+        total += stats->buckets[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    // Rank of the sample, rounded up so p100 is the slowest call
+    uint64_t rank = ((uint64_t)total * percentile + 99) / 100;
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (uint8_t i = 0; i < WIFI_RPC_BUCKETS - 1; i++) {
+        seen += stats->buckets[i];
+        if (seen >= rank) {
+            return 1u << i;
+        }
+    }
+    return stats->max_us;
+}
+
+size_t wifi_rpc_format_stats(char* buf, size_t size, wifi_rpc_call_t call, wifi_rpc_stats_t const* stats) {
+    if (size == 0) {
+        return 0;
+    }
+    uint64_t avg = stats->calls ? stats->total_us / stats->calls : 0;
+    int      len = snprintf(buf, size,
+                            "%s %" PRIu32 " calls %" PRIu32 " failed %" PRIu64 " B avg %" PRIu64 " p50 %" PRIu32
+                            " p99 %" PRIu32 " max %" PRIu32 " us",
+                            wifi_rpc_name(call), stats->calls, stats->failures, stats->bytes, avg,
+                            wifi_rpc_percentile_us(stats, 50), wifi_rpc_percentile_us(stats, 99), stats->max_us);
+    if (len < 0) {
+        buf[0] = '\0';
+        return 0;
+    }
+    return (size_t)len < size ? (size_t)len : size - 1;
+}
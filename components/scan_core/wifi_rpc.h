@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_wifi.h"
+
+// Drop-in wrappers for the esp_wifi calls the application makes. With esp-hosted every one of
+// them is a round trip over SDIO to the radio co-processor; the wrappers time each call into a
+// log2-bucketed latency histogram and count calls, failures and payload bytes per call type.
+// On the linux target and in the host build the calls land in the stubs/ mock, whose latency
+// is set with wifi_stub_set_latency().
+
+// Bucket b counts calls that took [2^(b-1), 2^b) us, bucket 0 those under 1 us. The last
+// bucket also takes everything slower.
+#define WIFI_RPC_BUCKETS 24
+
+typedef enum {
+    WIFI_RPC_INIT,
+    WIFI_RPC_SET_MODE,
+    WIFI_RPC_SET_CONFIG,
+    WIFI_RPC_START,
+    WIFI_RPC_STOP,
+    WIFI_RPC_SCAN_START,
+    WIFI_RPC_SCAN_STOP,
+    WIFI_RPC_SCAN_GET_AP_NUM,
+    WIFI_RPC_SCAN_GET_AP_RECORDS,
+    WIFI_RPC_SCAN_GET_AP_RECORD,
+    WIFI_RPC_CLEAR_AP_LIST,
+    WIFI_RPC_CALL_COUNT,
+} wifi_rpc_call_t;
+
+typedef struct {
+    uint32_t calls;
+    uint32_t failures;
+    uint64_t bytes;     // Arguments and results, without esp-hosted framing
+    uint64_t total_us;
+    uint32_t max_us;
+    uint32_t buckets[WIFI_RPC_BUCKETS];
+} wifi_rpc_stats_t;
+
+esp_err_t wifi_rpc_init(wifi_init_config_t const* config);
+esp_err_t wifi_rpc_set_mode(wifi_mode_t mode);
+esp_err_t wifi_rpc_set_config(wifi_interface_t interface, wifi_config_t* config);
+esp_err_t wifi_rpc_start(void);
+esp_err_t wifi_rpc_stop(void);
+esp_err_t wifi_rpc_scan_start(wifi_scan_config_t const* config, bool block);
+esp_err_t wifi_rpc_scan_stop(void);
+esp_err_t wifi_rpc_scan_get_ap_num(uint16_t* number);
+esp_err_t wifi_rpc_scan_get_ap_records(uint16_t* number, wifi_ap_record_t* records);
+esp_err_t wifi_rpc_scan_get_ap_record(wifi_ap_record_t* record);
+esp_err_t wifi_rpc_clear_ap_list(void);
+
+char const* wifi_rpc_name(wifi_rpc_call_t call);
+
+// Snapshot of the counters of one call type. Safe while other tasks make calls, though the
+// fields are read one by one and need not be consistent with each other.
+void wifi_rpc_get_stats(wifi_rpc_call_t call, wifi_rpc_stats_t* out);
+void wifi_rpc_reset_stats(void);
+
+// Upper bound of the bucket holding the given percentile (0 to 100), 0 without calls
+uint32_t wifi_rpc_percentile_us(wifi_rpc_stats_t const* stats, uint8_t percentile);
+
+// Write a single line summarizing the stats into buf, for example:
+// "scan_get_ap_records 12 calls 0 failed 9600 B avg 1830 p50 2048 p99 4096 max 3911 us"
+// The output is always terminated and truncated to fit. Returns the length written.
+size_t wifi_rpc_format_stats(char* buf, size_t size, wifi_rpc_call_t call, wifi_rpc_stats_t const* stats);
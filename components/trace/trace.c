@@ -0,0 +1,117 @@
+#include "trace.h"
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "memstat.h"
+
+#define TRACE_TASKS       16  // Distinct tasks with their own track, later ones share "other"
+#define TRACE_STACK_SIZE  3072
+#define TRACE_PRIORITY    1
+
+typedef struct {
+    char const* name;
+    int64_t     start_us;
+    uint32_t    duration_us;
+    uint8_t     task;
+    uint8_t     core;
+} trace_event_t;
+
+typedef struct {
+    TaskHandle_t handle;
+    char         name[configMAX_TASK_NAME_LEN];
+} trace_task_t;
+
+static char const TAG[] = "trace";
+
+static trace_event_t events[CONFIG_TRACE_EVENTS];
+static uint32_t      event_next    = 0;  // Total spans recorded, the slot is taken modulo the size
+static trace_task_t  tasks[TRACE_TASKS];
+static uint8_t       task_count    = 0;
+static portMUX_TYPE  trace_lock    = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool paused        = false;
+static TaskHandle_t  dump_task     = NULL;
+
+// Called with trace_lock held. Task handles can be reused after a task is deleted, the name is
+// copied so the track still reads right for spans of the old task.
+static uint8_t trace_task_index(TaskHandle_t handle) {
+    for (uint8_t i = 0; i < task_count; i++) {
+        if (tasks[i].handle == handle) {
+            return i;
+        }
+    }
+    if (task_count == TRACE_TASKS) {
+        return TRACE_TASKS;
+    }
+    tasks[task_count].handle = handle;
+    strlcpy(tasks[task_count].name, pcTaskGetName(handle), sizeof(tasks[task_count].name));
+    return task_count++;
+}
+
+trace_span_t trace_begin(char const* name) {
+    return (trace_span_t){name, esp_timer_get_time()};
+}
+
+void trace_end(trace_span_t const* span) {
+    int64_t end = esp_timer_get_time();
+    if (paused) {
+        return;
+    }
+    TaskHandle_t handle = xTaskGetCurrentTaskHandle();
+    taskENTER_CRITICAL(&trace_lock);
+    trace_event_t* event = &events[event_next++ % CONFIG_TRACE_EVENTS];
+    event->name          = span->name;
+    event->start_us      = span->start_us;
+    event->duration_us   = (uint32_t)(end - span->start_us);
+    event->task          = trace_task_index(handle);
+    event->core          = xPortGetCoreID();
+    taskEXIT_CRITICAL(&trace_lock);
+}
+
+static void trace_dump_task(void* arg) {
+    // Wait out writers that saw paused == false, they finish inside the critical section
+    paused = true;
+    taskENTER_CRITICAL(&trace_lock);
+    uint32_t total = event_next;
+    taskEXIT_CRITICAL(&trace_lock);
+
+    uint32_t count = total < CONFIG_TRACE_EVENTS ? total : CONFIG_TRACE_EVENTS;
+    ESP_LOGI(TAG, "Dumping %" PRIu32 " spans (%" PRIu32 " overwritten)", count, total - count);
+
+    printf("{\"traceEvents\":[\n");
+    printf("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"%s\"}}", CONFIG_IDF_TARGET);
+    for (uint8_t i = 0; i <= task_count && i <= TRACE_TASKS; i++) {
+        char const* name = i < task_count ? tasks[i].name : "other";
+        printf(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", i, name);
+    }
+    for (uint32_t i = total - count; i != total; i++) {
+        trace_event_t const* event = &events[i % CONFIG_TRACE_EVENTS];
+        printf(",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%" PRId64 ",\"dur\":%" PRIu32
+               ",\"args\":{\"core\":%u}}",
+               event->name, event->task, event->start_us, event->duration_us, event->core);
+    }
+    printf("\n]}\n");
+    fflush(stdout);
+
+    taskENTER_CRITICAL(&trace_lock);
+    event_next = 0;
+    taskEXIT_CRITICAL(&trace_lock);
+    paused    = false;
+    dump_task = NULL;
+    memstat_task_exit();
+}
+
+esp_err_t trace_dump_start(void) {
+    if (dump_task != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (memstat_task_create(trace_dump_task, "trace_dump", TRACE_STACK_SIZE, NULL, TRACE_PRIORITY, &dump_task,
+                            tskNO_AFFINITY) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+// Lightweight span tracing into a fixed-size RAM buffer, exported as Chrome trace-event JSON
+// (chrome://tracing, ui.perfetto.dev). Spans record their task and core; once the buffer is
+// full the oldest spans are overwritten.
+//
+//   trace_span_t span = trace_begin("pax_buf_init");
+//   pax_buf_init(...);
+//   trace_end(&span);
+
+typedef struct {
+    char const* name;  // Must outlive the trace, normally a string literal
+    int64_t     start_us;
+} trace_span_t;
+
+#if defined(CONFIG_TRACE_ENABLE)
+
+trace_span_t trace_begin(char const* name);
+void         trace_end(trace_span_t const* span);
+
+// Print the buffer as JSON from a low priority task, then clear it. Recording is paused while
+// the dump runs. ESP_ERR_INVALID_STATE if a dump is already in progress.
+esp_err_t trace_dump_start(void);
+
+#else
+
+static inline trace_span_t trace_begin(char const* name) {
+    return (trace_span_t){name, 0};
+}
+
+static inline void trace_end(trace_span_t const* span) {
+    (void)span;
+}
+
+static inline esp_err_t trace_dump_start(void) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif
+
+// Trace a single call returning esp_err_t, for example an esp_wifi RPC
+#define TRACE_CALL(name, call)                            \
+    ({                                                    \
+        trace_span_t trace_call_span = trace_begin(name); \
+        esp_err_t    trace_call_res  = (call);            \
+        trace_end(&trace_call_span);                      \
+        trace_call_res;                                   \
+    })
@@ -0,0 +1,86 @@
+#include "alloc_track.h"
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Every block is prefixed with its size, padded to keep the payload aligned like malloc does
+#define HEADER_SIZE alignof(max_align_t)
+
+void* __real_malloc(size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void  __real_free(void* ptr);
+
+static alloc_stats_t stats = {0};
+
+static void* track(void* block, size_t size) {
+    if (block == NULL) {
+        return NULL;
+    }
+    memcpy(block, &size, sizeof(size));
+    stats.current += size;
+    if (stats.current > stats.peak) {
+        stats.peak = stats.current;
+    }
+    return (char*)block + HEADER_SIZE;
+}
+
+static size_t untrack(void* ptr) {
+    size_t size;
+    memcpy(&size, ptr, sizeof(size));
+    stats.current -= size;
+    return size;
+}
+
+void* __wrap_malloc(size_t size) {
+    stats.allocations++;
+    return track(__real_malloc(size + HEADER_SIZE), size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    if (size != 0 && count > SIZE_MAX / size) {
+        return NULL;
+    }
+    void* ptr = __wrap_malloc(count * size);
+    if (ptr) {
+        memset(ptr, 0, count * size);
+    }
+    return ptr;
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    if (ptr == NULL) {
+        return __wrap_malloc(size);
+    }
+    void*  block = (char*)ptr - HEADER_SIZE;
+    size_t old   = untrack(block);
+    if (size > old) {
+        stats.allocations++;
+    }
+    void* grown = __real_realloc(block, size + HEADER_SIZE);
+    if (grown == NULL) {
+        stats.current += old;  // The old block is still valid
+        return NULL;
+    }
+    return track(grown, size);
+}
+
+void __wrap_free(void* ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    stats.frees++;
+    void* block = (char*)ptr - HEADER_SIZE;
+    untrack(block);
+    __real_free(block);
+}
+
+void alloc_track_reset(void) {
+    stats.allocations = 0;
+    stats.frees       = 0;
+    stats.peak        = stats.current;
+}
+
+alloc_stats_t alloc_track_get(void) {
+    return stats;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Heap accounting for the benchmarks. The executables are linked with --wrap for malloc,
+// calloc, realloc and free, so every heap call made by the code under test is counted.
+typedef struct {
+    uint64_t allocations;  // malloc, calloc and growing realloc calls
+    uint64_t frees;
+    size_t   current;      // Bytes live right now
+    size_t   peak;         // Highest `current` since the last reset
+} alloc_stats_t;
+
+// Zero the counters and restart peak tracking from the bytes currently live
+void          alloc_track_reset(void);
+alloc_stats_t alloc_track_get(void);
@@ -0,0 +1,244 @@
+// Compares the per-AP console output of the old wifi_scan() path (wifi_desc_record plus
+// print_auth_mode / print_cipher_type and the SSID/RSSI/channel lines) against
+// ap_format_record(). Log calls are emulated by formatting into a sink the way ESP_LOGI
+// would, so the numbers cover formatting cost, not console throughput.
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ap_format.h"
+
+#define RECORD_COUNT 1000
+#define ITERATIONS   200
+
+static char     sink_buffer[256];
+static uint64_t sink_bytes  = 0;
+static uint64_t sink_lines  = 0;
+static uint64_t allocations = 0;
+
+static void sink_log(char const* format, ...) {
+    int prefix = snprintf(sink_buffer, sizeof(sink_buffer), "I (%lu) %s: ", 123456ul, "main");
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(sink_buffer + prefix, sizeof(sink_buffer) - prefix, format, args);
+    va_end(args);
+    sink_bytes += prefix + length + 1;
+    sink_lines++;
+}
+
+static void sink_printf(char const* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(sink_buffer, sizeof(sink_buffer), format, args);
+    va_end(args);
+    sink_bytes += length;
+    sink_lines++;
+}
+
+static void* counted_malloc(size_t size) {
+    allocations++;
+    return malloc(size);
+}
+
+// Old implementation, reduced to the sink
+
+static void legacy_print_auth_mode(int authmode) {
+    switch (authmode) {
+        case WIFI_AUTH_OPEN:
+            sink_log("Authmode \tWIFI_AUTH_OPEN");
+            break;
+        case WIFI_AUTH_OWE:
+            sink_log("Authmode \tWIFI_AUTH_OWE");
+            break;
+        case WIFI_AUTH_WEP:
+            sink_log("Authmode \tWIFI_AUTH_WEP");
+            break;
+        case WIFI_AUTH_WPA_PSK:
+            sink_log("Authmode \tWIFI_AUTH_WPA_PSK");
+            break;
+        case WIFI_AUTH_WPA2_PSK:
+            sink_log("Authmode \tWIFI_AUTH_WPA2_PSK");
+            break;
+        case WIFI_AUTH_WPA_WPA2_PSK:
+            sink_log("Authmode \tWIFI_AUTH_WPA_WPA2_PSK");
+            break;
+        case WIFI_AUTH_ENTERPRISE:
+            sink_log("Authmode \tWIFI_AUTH_ENTERPRISE");
+            break;
+        case WIFI_AUTH_WPA3_PSK:
+            sink_log("Authmode \tWIFI_AUTH_WPA3_PSK");
+            break;
+        case WIFI_AUTH_WPA2_WPA3_PSK:
+            sink_log("Authmode \tWIFI_AUTH_WPA2_WPA3_PSK");
+            break;
+        case WIFI_AUTH_WPA3_ENTERPRISE:
+            sink_log("Authmode \tWIFI_AUTH_WPA3_ENTERPRISE");
+            break;
+        case WIFI_AUTH_WPA2_WPA3_ENTERPRISE:
+            sink_log("Authmode \tWIFI_AUTH_WPA2_WPA3_ENTERPRISE");
+            break;
+        case WIFI_AUTH_WPA3_ENT_192:
+            sink_log("Authmode \tWIFI_AUTH_WPA3_ENT_192");
+            break;
+        default:
+            sink_log("Authmode \tWIFI_AUTH_UNKNOWN");
+            break;
+    }
+}
+
+static void legacy_print_cipher(char const* label, int cipher) {
+    switch (cipher) {
+        case WIFI_CIPHER_TYPE_NONE:
+            sink_log("%s Cipher \tWIFI_CIPHER_TYPE_NONE", label);
+            break;
+        case WIFI_CIPHER_TYPE_WEP40:
+            sink_log("%s Cipher \tWIFI_CIPHER_TYPE_WEP40", label);
+            break;
+        case WIFI_CIPHER_TYPE_WEP104:
+            sink_log("%s Cipher \tWIFI_CIPHER_TYPE_WEP104", label);
+            break;
+        case WIFI_CIPHER_TYPE_TKIP:
+            sink_log("%s Cipher \tWIFI_CIPHER_TYPE_TKIP", label);
+            break;
+        case WIFI_CIPHER_TYPE_CCMP:
+            sink_log("%s Cipher \tWIFI_CIPHER_TYPE_CCMP", label);
+            break;
+        case WIFI_CIPHER_TYPE_TKIP_CCMP:
+            sink_log("%s Cipher \tWIFI_CIPHER_TYPE_TKIP_CCMP", label);
+            break;
+        case WIFI_CIPHER_TYPE_AES_CMAC128:
+            sink_log("%s Cipher \tWIFI_CIPHER_TYPE_AES_CMAC128", label);
+            break;
+        case WIFI_CIPHER_TYPE_SMS4:
+            sink_log("%s Cipher \tWIFI_CIPHER_TYPE_SMS4", label);
+            break;
+        case WIFI_CIPHER_TYPE_GCMP:
+            sink_log("%s Cipher \tWIFI_CIPHER_TYPE_GCMP", label);
+            break;
+        case WIFI_CIPHER_TYPE_GCMP256:
+            sink_log("%s Cipher \tWIFI_CIPHER_TYPE_GCMP256", label);
+            break;
+        default:
+            sink_log("%s Cipher \tWIFI_CIPHER_TYPE_UNKNOWN", label);
+            break;
+    }
+}
+
+static void legacy_desc_record(wifi_ap_record_t const* record) {
+    char* bssid_str = counted_malloc(3 * 6);
+    if (!bssid_str) return;
+    snprintf(bssid_str, 3 * 6, "%02X:%02X:%02X:%02X:%02X:%02X", record->bssid[0], record->bssid[1], record->bssid[2],
+             record->bssid[3], record->bssid[4], record->bssid[5]);
+
+    char* phy_str = counted_malloc(9);
+    if (!phy_str) {
+        free(bssid_str);
+        return;
+    }
+    *phy_str = 0;
+    if (record->phy_11b | record->phy_11g | record->phy_11n) {
+        strcpy(phy_str, " 1");
+    }
+    if (record->phy_11b) {
+        strcat(phy_str, "/b");
+    }
+    if (record->phy_11g) {
+        strcat(phy_str, "/g");
+    }
+    if (record->phy_11n) {
+        strcat(phy_str, "/n");
+    }
+    phy_str[2] = '1';
+
+    sink_printf("AP %s %s rssi=%hhd%s\r\n", bssid_str, record->ssid, record->rssi, phy_str);
+    free(bssid_str);
+    free(phy_str);
+}
+
+static void legacy_record(wifi_ap_record_t const* record) {
+    legacy_desc_record(record);
+    sink_log("SSID \t\t%s", record->ssid);
+    sink_log("RSSI \t\t%d", record->rssi);
+    legacy_print_auth_mode(record->authmode);
+    if (record->authmode != WIFI_AUTH_WEP) {
+        legacy_print_cipher("Pairwise", record->pairwise_cipher);
+        legacy_print_cipher("Group", record->group_cipher);
+    }
+    sink_log("Channel \t\t%d", record->primary);
+}
+
+static void table_record(wifi_ap_record_t const* record) {
+    char line[AP_FORMAT_LINE_MAX];
+    ap_format_record(line, sizeof(line), record);
+    sink_log("%s", line);
+}
+
+// Synthetic input
+
+static uint32_t random_next(uint32_t* state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+static void generate_records(wifi_ap_record_t* records, size_t count) {
+    static wifi_auth_mode_t const   modes[]   = {WIFI_AUTH_OPEN, WIFI_AUTH_WPA2_PSK, WIFI_AUTH_WPA_WPA2_PSK,
+                                                 WIFI_AUTH_WPA2_WPA3_PSK, WIFI_AUTH_ENTERPRISE, WIFI_AUTH_WPA3_PSK};
+    static wifi_cipher_type_t const ciphers[] = {WIFI_CIPHER_TYPE_CCMP, WIFI_CIPHER_TYPE_TKIP_CCMP,
+                                                 WIFI_CIPHER_TYPE_TKIP};
+    uint32_t state = 0x5eed;
+    memset(records, 0, sizeof(wifi_ap_record_t) * count);
+    for (size_t i = 0; i < count; i++) {
+        wifi_ap_record_t* record = &records[i];
+        for (int b = 0; b < 6; b++) {
+            record->bssid[b] = random_next(&state) & 0xFF;
+        }
+        snprintf((char*)record->ssid, sizeof(record->ssid), "venue-net-%u", (unsigned)(random_next(&state) % 500));
+        record->primary         = 1 + random_next(&state) % 13;
+        record->rssi            = -30 - (int)(random_next(&state) % 65);
+        record->authmode        = modes[random_next(&state) % (sizeof(modes) / sizeof(modes[0]))];
+        record->pairwise_cipher = ciphers[random_next(&state) % (sizeof(ciphers) / sizeof(ciphers[0]))];
+        record->group_cipher    = ciphers[random_next(&state) % (sizeof(ciphers) / sizeof(ciphers[0]))];
+        record->phy_11b         = 1;
+        record->phy_11g         = 1;
+        record->phy_11n         = random_next(&state) & 1;
+        record->phy_11ax        = random_next(&state) % 4 == 0;
+    }
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void run(char const* name, void (*format)(wifi_ap_record_t const*), wifi_ap_record_t const* records) {
+    sink_bytes  = 0;
+    sink_lines  = 0;
+    allocations = 0;
+    double start = now_ns();
+    for (int iteration = 0; iteration < ITERATIONS; iteration++) {
+        for (size_t i = 0; i < RECORD_COUNT; i++) {
+            format(&records[i]);
+        }
+    }
+    double   elapsed = now_ns() - start;
+    uint64_t total   = (uint64_t)ITERATIONS * RECORD_COUNT;
+    printf("%-8s %8.1f ns/record %7.1f bytes/record %5.2f lines/record %5.2f mallocs/record\n", name,
+           elapsed / total, (double)sink_bytes / total, (double)sink_lines / total, (double)allocations / total);
+}
+
+int main(void) {
+    static wifi_ap_record_t records[RECORD_COUNT];
+    generate_records(records, RECORD_COUNT);
+
+    char line[AP_FORMAT_LINE_MAX];
+    ap_format_record(line, sizeof(line), &records[0]);
+    printf("Sample: %s\n", line);
+
+    run("legacy", legacy_record, records);
+    run("table", table_record, records);
+    return 0;
+}
@@ -0,0 +1,116 @@
+// Feeds synthetic background scans into the RSSI history of ap_history.h. Every scan misses a
+// random share of the APs, the way distant APs drop in and out. Reports the cost per record and
+// per scan, checks that nothing is allocated once the table exists, and checks the statistics
+// of every tracked AP against a plain recomputation over its samples.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "alloc_track.h"
+#include "ap_history.h"
+#include "esp_wifi.h"
+#include "scan_pipeline.h"
+#include "wifi_stub.h"
+
+#define HISTORY_LOG2 11
+#define SCANS        500
+#define MISS_PERCENT 20
+
+static bool history_check(ap_history_t const* history) {
+    for (uint32_t i = 0; i < history->capacity; i++) {
+        ap_history_slot_t const* slot = &history->slots[i];
+        if (!slot->used) {
+            continue;
+        }
+        if (ap_history_find(history, slot->bssid) != slot) {
+            return false;
+        }
+        int8_t             samples[AP_HISTORY_SAMPLES];
+        uint8_t            count   = ap_history_copy(slot, samples);
+        int                present = 0;
+        int                sum     = 0;
+        ap_history_stats_t stats;
+        ap_history_stats(slot, &stats);
+        for (uint8_t j = 0; j < count; j++) {
+            if (samples[j] == AP_HISTORY_MISSING) {
+                continue;
+            }
+            if (samples[j] < stats.min || samples[j] > stats.max) {
+                return false;
+            }
+            sum += samples[j];
+            present++;
+        }
+        if (present != stats.present || present + stats.missed != count ||
+            (present && stats.mean != sum * (1 << AP_HISTORY_SHIFT) / present)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int run_size(uint16_t count) {
+    uint32_t           capacity = 1u << HISTORY_LOG2;
+    ap_history_slot_t* slots    = malloc(sizeof(ap_history_slot_t) * capacity);
+    wifi_ap_record_t*  records  = malloc(sizeof(wifi_ap_record_t) * count);
+    if (slots == NULL || records == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    ap_history_t history;
+    ap_history_init(&history, slots, capacity);
+    srand(count);
+
+    double   record_ns = 0;
+    double   end_ns    = 0;
+    uint64_t fed       = 0;
+    uint64_t updated   = 0;
+    uint64_t allocs    = 0;
+    for (uint32_t scan = 0; scan < SCANS; scan++) {
+        wifi_stub_generate(count, scan + 1);
+        uint16_t fetched = count;
+        esp_wifi_scan_get_ap_records(&fetched, records);
+
+        alloc_track_reset();
+        double start = pipeline_now_ns();
+        ap_history_begin_scan(&history);
+        for (uint16_t i = 0; i < fetched; i++) {
+            if (rand() % 100 >= MISS_PERCENT) {
+                ap_history_record(&history, &records[i]);
+                fed++;
+            }
+        }
+        double middle = pipeline_now_ns();
+        ap_history_end_scan(&history);
+        end_ns    += pipeline_now_ns() - middle;
+        record_ns += middle - start;
+        updated   += history.updated;
+        allocs    += alloc_track_get().allocations;
+    }
+    if (!history_check(&history)) {
+        fprintf(stderr, "History of %u APs inconsistent\n", count);
+        return 1;
+    }
+    printf("%6u %6u %10.1f %10.1f %10.1f %8u %8u %8llu\n", count, SCANS, record_ns / fed, end_ns / SCANS / 1000,
+           (double)updated / SCANS, history.count, history.dropped, (unsigned long long)allocs);
+
+    free(slots);
+    free(records);
+    return 0;
+}
+
+int main(void) {
+    static uint16_t const sizes[] = {20, 100, 300, 1000};
+
+    printf("History: %d samples per AP, %u slots of %zu bytes\n", AP_HISTORY_SAMPLES, 1u << HISTORY_LOG2,
+           sizeof(ap_history_slot_t));
+    printf("%6s %6s %10s %10s %10s %8s %8s %8s\n", "APs", "scans", "record", "end scan", "updated", "tracked",
+           "dropped", "allocs");
+    printf("%6s %6s %10s %10s %10s %8s %8s %8s\n", "", "", "ns/AP", "us/scan", "APs/scan", "", "", "");
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        if (run_size(sizes[i]) != 0) {
+            return 1;
+        }
+    }
+    wifi_stub_reset();
+    return 0;
+}
@@ -0,0 +1,97 @@
+// Merges synthetic scans into the AP table and keeps the display order of ap_list.h up to date,
+// next to sorting the whole table from scratch after every scan. The order is checked after
+// every sync.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ap_cache.h"
+#include "ap_list.h"
+#include "esp_wifi.h"
+#include "scan_pipeline.h"
+#include "wifi_stub.h"
+
+#define CACHE_LOG2 11  // Large enough that 1000 APs do not evict each other
+#define SCANS      200
+
+static int compare_rssi(void const* a, void const* b) {
+    return ap_compare_rssi(a, b);
+}
+
+static bool list_sorted(ap_list_t const* list) {
+    for (uint16_t i = 1; i < list->count; i++) {
+        if (list->compare(&ap_list_at(list, i - 1)->record, &ap_list_at(list, i)->record) > 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int run_size(uint16_t count) {
+    uint32_t          capacity = 1u << CACHE_LOG2;
+    ap_cache_entry_t* entries  = calloc(capacity, sizeof(ap_cache_entry_t));
+    wifi_ap_record_t* records  = malloc(sizeof(wifi_ap_record_t) * count);
+    wifi_ap_record_t* sorted   = malloc(sizeof(wifi_ap_record_t) * capacity);
+    ap_cache_t        cache;
+    ap_list_t         list;
+    if (entries == NULL || records == NULL || sorted == NULL || ap_list_init(&list, capacity, NULL) != ESP_OK) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    ap_cache_init(&cache, entries, capacity, PIPELINE_CACHE_EWMA);
+
+    double   sync_ns = 0;
+    double   sort_ns = 0;
+    uint32_t changes = 0;
+    uint32_t moved   = list.moved;
+    for (uint32_t scan = 0; scan < SCANS; scan++) {
+        wifi_stub_generate(count, scan + 1);
+        uint16_t fetched = count;
+        esp_wifi_scan_get_ap_records(&fetched, records);
+        for (uint16_t i = 0; i < fetched; i++) {
+            ap_cache_update(&cache, &records[i], (int64_t)scan * 5000000);
+        }
+
+        double start = pipeline_now_ns();
+        changes += ap_list_sync(&list, &cache);
+        sync_ns += pipeline_now_ns() - start;
+        if (!list_sorted(&list) || list.count != cache.count) {
+            fprintf(stderr, "List out of order after scan %u\n", scan);
+            return 1;
+        }
+
+        // What the view would do without the incremental order
+        start          = pipeline_now_ns();
+        uint32_t total = 0;
+        for (uint32_t i = 0; i < capacity; i++) {
+            if (entries[i].used) {
+                sorted[total]        = entries[i].record;
+                sorted[total++].rssi = ap_cache_entry_rssi(&entries[i]);
+            }
+        }
+        qsort(sorted, total, sizeof(wifi_ap_record_t), compare_rssi);
+        sort_ns += pipeline_now_ns() - start;
+    }
+    printf("%6u %6u %10.1f %10.1f %10.1f %10.1f\n", count, SCANS, sync_ns / SCANS / 1000, sort_ns / SCANS / 1000,
+           (double)changes / SCANS, (double)(list.moved - moved) / SCANS);
+
+    ap_list_free(&list);
+    free(entries);
+    free(records);
+    free(sorted);
+    return 0;
+}
+
+int main(void) {
+    static uint16_t const sizes[] = {20, 100, 300, 1000};
+
+    printf("%6s %6s %10s %10s %10s %10s\n", "APs", "scans", "sync", "full sort", "changed", "moved");
+    printf("%6s %6s %10s %10s %10s %10s\n", "", "", "us/scan", "us/scan", "rows/scan", "rows/scan");
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        if (run_size(sizes[i]) != 0) {
+            return 1;
+        }
+    }
+    wifi_stub_reset();
+    return 0;
+}
@@ -0,0 +1,104 @@
+// Ranks the BSSIDs of one network out of synthetic scans, the way wifi_scan.c does after every
+// scan. A quarter of the APs are made part of the target network. After every update the
+// candidates are checked to be sorted and to belong to the target, and the best candidate is
+// reported as failing once in a while to check it is pushed down the list.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ap_cache.h"
+#include "ap_rank.h"
+#include "esp_wifi.h"
+#include "scan_pipeline.h"
+#include "wifi_stub.h"
+
+#define CACHE_LOG2     11
+#define SCANS          200
+#define TARGET         "venue-net-0"
+#define FAILURE_PERIOD 10  // Scans between failed attempts on the best candidate
+
+static bool rank_check(ap_rank_t const* rank, ap_cache_t* cache) {
+    for (uint8_t i = 0; i < rank->count; i++) {
+        ap_rank_candidate_t const* candidate = &rank->candidates[i];
+        ap_cache_entry_t const*    entry     = ap_cache_find(cache, candidate->bssid);
+        if (entry == NULL || strcmp((char const*)entry->record.ssid, TARGET) != 0) {
+            return false;
+        }
+        if (i > 0 && rank->candidates[i - 1].score < candidate->score) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int run_size(uint16_t count) {
+    uint32_t          capacity = 1u << CACHE_LOG2;
+    ap_cache_entry_t* entries  = calloc(capacity, sizeof(ap_cache_entry_t));
+    wifi_ap_record_t* records  = malloc(sizeof(wifi_ap_record_t) * count);
+    ap_rank_t*        rank     = malloc(sizeof(ap_rank_t));
+    if (entries == NULL || records == NULL || rank == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    ap_cache_t cache;
+    ap_cache_init(&cache, entries, capacity, PIPELINE_CACHE_EWMA);
+    ap_rank_init(rank);
+    ap_rank_set_target(rank, TARGET);
+
+    double   update_ns = 0;
+    uint32_t demoted   = 0;
+    uint32_t failures  = 0;
+    uint8_t  failed[6] = {0};
+    bool     pending   = false;
+    for (uint32_t scan = 0; scan < SCANS; scan++) {
+        wifi_stub_generate(count, scan + 1);
+        uint16_t fetched = count;
+        esp_wifi_scan_get_ap_records(&fetched, records);
+        for (uint16_t i = 0; i < fetched; i++) {
+            if (records[i].bssid[4] % 4 == 0) {
+                strcpy((char*)records[i].ssid, TARGET);
+            }
+            ap_cache_update(&cache, &records[i], (int64_t)scan * 5000000);
+        }
+
+        double start = pipeline_now_ns();
+        ap_rank_update(rank, &cache);
+        update_ns += pipeline_now_ns() - start;
+        if (!rank_check(rank, &cache)) {
+            fprintf(stderr, "Candidates of %u APs out of order after scan %u\n", count, scan);
+            return 1;
+        }
+
+        if (pending && rank->count > 1) {
+            demoted += memcmp(rank->candidates[0].bssid, failed, 6) != 0;
+            pending  = false;
+        }
+        if (scan % FAILURE_PERIOD == 0 && rank->count > 1) {
+            memcpy(failed, rank->candidates[0].bssid, 6);
+            ap_rank_report(rank, failed, false);
+            failures++;
+            pending = true;
+        }
+    }
+    printf("%6u %6u %10.2f %8u %8u %8u/%u\n", count, SCANS, update_ns / SCANS / 1000, rank->ess_count, rank->count,
+           demoted, failures);
+
+    free(entries);
+    free(records);
+    free(rank);
+    return 0;
+}
+
+int main(void) {
+    static uint16_t const sizes[] = {20, 100, 300, 1000};
+
+    printf("%6s %6s %10s %8s %8s %10s\n", "APs", "scans", "update", "ESSes", "ranked", "demoted");
+    printf("%6s %6s %10s %8s %8s %10s\n", "", "", "us/scan", "", "", "/failed");
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        if (run_size(sizes[i]) != 0) {
+            return 1;
+        }
+    }
+    wifi_stub_reset();
+    return 0;
+}
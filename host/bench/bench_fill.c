@@ -0,0 +1,112 @@
+// Fill throughput of the fb_fill kernels against storing one pixel at a time, the way PAX
+// clears, for each pixel format with whole bytes per pixel. Full 800x480 frames and 300x72
+// input bands are measured.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fb_fill.h"
+#include "scan_pipeline.h"
+
+#define WIDTH       800
+#define HEIGHT      480
+#define BAND_WIDTH  300
+#define BAND_HEIGHT 72
+#define BYTE_BUDGET (2000u * 1000 * 1000)  // Bytes written per format and method
+
+typedef struct {
+    char const* name;
+    uint8_t     bytes_per_pixel;
+    uint32_t    value;
+    bool        reversed;
+} format_t;
+
+// One pixel at a time, like a framebuffer setter
+static void __attribute__((noinline)) fill_pixels(uint8_t* base, size_t stride, int x, int y, int w, int h,
+                                                  uint32_t value, uint8_t bytes_per_pixel) {
+    for (int line = y; line < y + h; line++) {
+        uint8_t* row = base + line * stride;
+        for (int col = x; col < x + w; col++) {
+            switch (bytes_per_pixel) {
+                case 1:
+                    row[col] = value;
+                    break;
+                case 2:
+                    ((uint16_t*)row)[col] = value;
+                    break;
+                case 3:
+                    row[col * 3]     = value;
+                    row[col * 3 + 1] = value >> 8;
+                    row[col * 3 + 2] = value >> 16;
+                    break;
+                default:
+                    ((uint32_t*)row)[col] = value;
+                    break;
+            }
+        }
+    }
+}
+
+static double measure(uint8_t* frame, format_t const* format, int w, int h, bool kernel) {
+    size_t   stride = WIDTH * format->bytes_per_pixel;
+    size_t   bytes  = (size_t)w * h * format->bytes_per_pixel;
+    uint32_t rounds = BYTE_BUDGET / bytes;
+    uint32_t value  = format->reversed ? fb_fill_reverse(format->value, format->bytes_per_pixel) : format->value;
+    double   start  = pipeline_now_ns();
+    for (uint32_t round = 0; round < rounds; round++) {
+        // Move the band around so its rows start at every alignment
+        int x = (round * 7) % (WIDTH - w + 1);
+        int y = (round * 13) % (HEIGHT - h + 1);
+        if (kernel) {
+            fb_fill_rect(frame, stride, x, y, w, h, value, format->bytes_per_pixel);
+        } else {
+            fill_pixels(frame, stride, x, y, w, h, value, format->bytes_per_pixel);
+        }
+    }
+    double elapsed = pipeline_now_ns() - start;
+    return (double)bytes * rounds / elapsed * 1e3;  // MB/s
+}
+
+static int check(uint8_t* frame, uint8_t* expect, format_t const* format) {
+    size_t   stride = WIDTH * format->bytes_per_pixel;
+    uint32_t value  = format->reversed ? fb_fill_reverse(format->value, format->bytes_per_pixel) : format->value;
+    for (int x = 0; x < 40; x++) {
+        memset(frame, 0xAA, stride * 4);
+        memset(expect, 0xAA, stride * 4);
+        fb_fill_rect(frame, stride, x, 1, 2 * x + 1, 2, value, format->bytes_per_pixel);
+        fill_pixels(expect, stride, x, 1, 2 * x + 1, 2, value, format->bytes_per_pixel);
+        if (memcmp(frame, expect, stride * 4) != 0) {
+            fprintf(stderr, "%s fill differs at x %d\n", format->name, x);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(void) {
+    static format_t const formats[] = {
+        {"PAL8", 1, 0x5A, false},           {"RGB565", 2, 0x07E0, false},    {"RGB565 swapped", 2, 0x07E0, true},
+        {"RGB888", 3, 0x336699, false},     {"ARGB8888", 4, 0xFF336699, false},
+    };
+    uint8_t* frame  = malloc(WIDTH * HEIGHT * 4);
+    uint8_t* expect = malloc(WIDTH * HEIGHT * 4);
+    if (frame == NULL || expect == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    printf("%-16s %12s %12s %12s %12s\n", "format", "frame", "frame", "band", "band");
+    printf("%-16s %12s %12s %12s %12s\n", "", "pixel MB/s", "kernel MB/s", "pixel MB/s", "kernel MB/s");
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+        format_t const* format = &formats[i];
+        if (check(frame, expect, format) != 0) {
+            return 1;
+        }
+        printf("%-16s %12.0f %12.0f %12.0f %12.0f\n", format->name, measure(frame, format, WIDTH, HEIGHT, false),
+               measure(frame, format, WIDTH, HEIGHT, true), measure(frame, format, BAND_WIDTH, BAND_HEIGHT, false),
+               measure(frame, format, BAND_WIDTH, BAND_HEIGHT, true));
+    }
+    free(frame);
+    free(expect);
+    return 0;
+}
@@ -0,0 +1,115 @@
+// Replays a scan capture (see scan_capture.h) through the scan pipeline, either as fast as
+// possible or at the pace it was recorded at:
+//   bench_replay <capture> [--realtime] [--loops <n>]
+// A synthetic capture can be written for trying this out without a device:
+//   bench_replay --synthesize <capture> <aps> <scans>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_wifi.h"
+#include "scan_capture.h"
+#include "scan_pipeline.h"
+#include "scan_replay.h"
+#include "wifi_stub.h"
+
+#define SYNTHETIC_INTERVAL_US 5000000
+
+// Written the way the device does: one frame per fetched chunk, numbered per scan
+static int synthesize(char const* path, uint16_t aps, uint32_t scans) {
+    scan_capture_writer_t writer;
+    if (scan_capture_open(&writer, path) != ESP_OK) {
+        fprintf(stderr, "Cannot create %s\n", path);
+        return 1;
+    }
+    wifi_ap_record_t fetched[PIPELINE_FETCH_MAX];
+    uint64_t         written = 0;
+    for (uint32_t scan = 0; scan < scans; scan++) {
+        wifi_stub_generate(aps, scan + 1);
+        uint16_t count = aps < PIPELINE_FETCH_MAX ? aps : PIPELINE_FETCH_MAX;
+        esp_wifi_scan_get_ap_records(&count, fetched);
+        written += count;
+        for (uint16_t offset = 0; offset < count; offset += PIPELINE_FETCH_CHUNK) {
+            uint16_t length = count - offset < PIPELINE_FETCH_CHUNK ? count - offset : PIPELINE_FETCH_CHUNK;
+            scan_capture_write(&writer, scan, (int64_t)scan * SYNTHETIC_INTERVAL_US, &fetched[offset], length);
+        }
+    }
+    printf("Wrote %u scans of %u APs, %u frames, %llu bytes (%.1f bytes/AP)\n", scans,
+           (unsigned)(written / (scans ? scans : 1)), writer.frames, (unsigned long long)writer.bytes,
+           (double)writer.bytes / (written ? written : 1));
+    scan_capture_close(&writer);
+    wifi_stub_reset();
+    return 0;
+}
+
+static int replay(char const* path, bool realtime, uint32_t loops) {
+    scan_replay_t session;
+    esp_err_t     res = scan_replay_open(&session, path, realtime);
+    if (res != ESP_OK) {
+        fprintf(stderr, "Cannot replay %s: error 0x%x\n", path, res);
+        return 1;
+    }
+    pipeline_t pipeline;
+    if (pipeline_init(&pipeline) != 0) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    uint32_t scans    = 0;
+    int64_t  first_us = 0;
+    int64_t  last_us  = 0;
+    double   start    = pipeline_now_ns();
+    for (uint32_t loop = 0; loop < loops; loop++) {
+        scan_replay_rewind(&session);
+        int64_t timestamp_us;
+        while ((res = scan_replay_next(&session, &timestamp_us, NULL)) == ESP_OK) {
+            if (scans++ == 0) {
+                first_us = timestamp_us;
+            }
+            last_us = timestamp_us;
+            pipeline_run_scan(&pipeline, timestamp_us);
+        }
+        if (res != ESP_ERR_NOT_FOUND) {
+            fprintf(stderr, "Capture is damaged after %u scans\n", session.scans);
+            break;
+        }
+    }
+    double wall = pipeline_now_ns() - start;
+
+    pipeline_ns_t const* ns   = &pipeline.ns;
+    double               aps  = pipeline.aps ? pipeline.aps : 1;
+    double               busy = ns->fetch + ns->cache + ns->topk + ns->format;
+    printf("%u scans, %llu APs (%.1f APs/scan), captured over %.1f s, replayed in %.3f s\n", scans,
+           (unsigned long long)pipeline.aps, aps / (scans ? scans : 1), (last_us - first_us) / 1e6, wall / 1e9);
+    printf("fetch %.1f ns/AP, table %.1f ns/AP, topk %.1f ns/AP, format %.1f ns/line, %.2f M APs/s\n",
+           ns->fetch / aps, ns->cache / aps, ns->topk / aps, ns->format / (pipeline.lines ? pipeline.lines : 1),
+           aps / busy * 1e3);
+    printf("AP table: %u of %u entries, %u inserted, %u evicted\n", pipeline.cache.count, pipeline.cache.capacity,
+           pipeline.cache.inserted, pipeline.cache.evicted);
+
+    pipeline_free(&pipeline);
+    scan_replay_close(&session);
+    wifi_stub_reset();
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc == 5 && strcmp(argv[1], "--synthesize") == 0) {
+        return synthesize(argv[2], atoi(argv[3]), atoi(argv[4]));
+    }
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <capture> [--realtime] [--loops <n>]\n", argv[0]);
+        fprintf(stderr, "       %s --synthesize <capture> <aps> <scans>\n", argv[0]);
+        return 1;
+    }
+    bool     realtime = false;
+    uint32_t loops    = 1;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--realtime") == 0) {
+            realtime = true;
+        } else if (strcmp(argv[i], "--loops") == 0 && i + 1 < argc) {
+            loops = atoi(argv[++i]);
+        }
+    }
+    return replay(argv[1], realtime, loops);
+}
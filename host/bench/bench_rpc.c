@@ -0,0 +1,125 @@
+// Runs the esp_wifi call sequence of a scan session through the wifi_rpc shim against the stub
+// radio with a mocked round trip, and prints the latency histograms the shim collects:
+//   bench_rpc [--base <us>] [--jitter <us>] [--per-kib <us>] [--aps <n>] [--scans <n>]
+// Each scan fetches its records twice, once in a single call the way wifi_scan_session.c does,
+// and once record by record to show what a round trip per record costs.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "wifi_rpc.h"
+#include "wifi_stub.h"
+
+#define DEFAULT_APS   100
+#define DEFAULT_SCANS 20
+
+static void print_histogram(wifi_rpc_call_t call) {
+    wifi_rpc_stats_t stats;
+    wifi_rpc_get_stats(call, &stats);
+    uint32_t peak = 0;
+    for (uint8_t i = 0; i < WIFI_RPC_BUCKETS; i++) {
+        peak = stats.buckets[i] > peak ? stats.buckets[i] : peak;
+    }
+    printf("%s:\n", wifi_rpc_name(call));
+    for (uint8_t i = 0; i < WIFI_RPC_BUCKETS; i++) {
+        if (stats.buckets[i] == 0) {
+            continue;
+        }
+        char bar[41];
+        int  width = (int)((uint64_t)stats.buckets[i] * 40 / peak);
+        memset(bar, '#', width);
+        bar[width] = '\0';
+        printf("  < %8u us %8u %s\n", 1u << i, stats.buckets[i], bar);
+    }
+}
+
+static int run(uint16_t aps, uint32_t scans) {
+    wifi_init_config_t init = WIFI_INIT_CONFIG_DEFAULT();
+    wifi_config_t      sta  = {0};
+    wifi_scan_config_t scan = {.show_hidden = true};
+    esp_err_t          res  = wifi_rpc_init(&init);
+    if (res == ESP_OK) {
+        res = wifi_rpc_set_mode(WIFI_MODE_STA);
+    }
+    if (res == ESP_OK) {
+        res = wifi_rpc_set_config(WIFI_IF_STA, &sta);
+    }
+    if (res == ESP_OK) {
+        res = wifi_rpc_start();
+    }
+    if (res != ESP_OK) {
+        fprintf(stderr, "Stub radio did not start: error 0x%x\n", res);
+        return 1;
+    }
+
+    wifi_ap_record_t* records = malloc(sizeof(wifi_ap_record_t) * aps);
+    if (records == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    for (uint32_t i = 0; i < scans; i++) {
+        uint16_t count = 0;
+        wifi_stub_generate(aps, i + 1);
+        wifi_rpc_scan_start(&scan, false);
+        wifi_rpc_scan_get_ap_num(&count);
+        wifi_rpc_scan_get_ap_records(&count, records);
+
+        wifi_stub_generate(aps, i + 1);
+        wifi_rpc_scan_start(&scan, false);
+        wifi_rpc_scan_get_ap_num(&count);
+        while (wifi_rpc_scan_get_ap_record(&records[0]) == ESP_OK) {
+        }
+        wifi_rpc_clear_ap_list();
+    }
+    wifi_rpc_scan_stop();
+    wifi_rpc_stop();
+    free(records);
+    wifi_stub_reset();
+
+    char line[160];
+    for (wifi_rpc_call_t call = 0; call < WIFI_RPC_CALL_COUNT; call++) {
+        wifi_rpc_stats_t stats;
+        wifi_rpc_get_stats(call, &stats);
+        wifi_rpc_format_stats(line, sizeof(line), call, &stats);
+        printf("%s\n", line);
+    }
+    printf("\n");
+    print_histogram(WIFI_RPC_SCAN_GET_AP_RECORDS);
+    print_histogram(WIFI_RPC_SCAN_GET_AP_RECORD);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    // Rough figures for a 4-bit SDIO link, override them with measurements from a device
+    wifi_stub_latency_t latency = {.base_us = 400, .jitter_us = 200, .per_kib_us = 60};
+    uint16_t            aps     = DEFAULT_APS;
+    uint32_t            scans   = DEFAULT_SCANS;
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 == argc) {
+            fprintf(stderr, "Missing value for %s\n", argv[i]);
+            return 1;
+        }
+        unsigned long value = strtoul(argv[i + 1], NULL, 0);
+        if (strcmp(argv[i], "--base") == 0) {
+            latency.base_us = value;
+        } else if (strcmp(argv[i], "--jitter") == 0) {
+            latency.jitter_us = value;
+        } else if (strcmp(argv[i], "--per-kib") == 0) {
+            latency.per_kib_us = value;
+        } else if (strcmp(argv[i], "--aps") == 0 && value > 0 && value <= UINT16_MAX) {
+            aps = value;
+        } else if (strcmp(argv[i], "--scans") == 0) {
+            scans = value;
+        } else {
+            fprintf(stderr,
+                    "Usage: %s [--base <us>] [--jitter <us>] [--per-kib <us>] [--aps <n>] [--scans <n>]\n",
+                    argv[0]);
+            return 1;
+        }
+        i++;
+    }
+    wifi_stub_set_latency(&latency);
+    printf("Mocked round trip %u us + up to %u us jitter + %u us/KiB, %u APs, %u scans\n\n", latency.base_us,
+           latency.jitter_us, latency.per_kib_us, aps, scans);
+    return run(aps, scans);
+}
@@ -0,0 +1,61 @@
+// Replays synthetic scans of 10 to 10000 APs through the scan pipeline (see scan_pipeline.h).
+// For each size the time per stage, heap allocations per scan and heap use on top of the
+// synthetic scan list are reported.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "alloc_track.h"
+#include "scan_pipeline.h"
+#include "wifi_stub.h"
+
+#define RECORD_BUDGET 2000000  // Records processed per scan size
+
+static void run_size(uint16_t count) {
+    uint32_t scans = RECORD_BUDGET / count;
+    if (scans < 20) {
+        scans = 20;
+    }
+
+    // Grow the stub list up front, it stands in for memory owned by the radio
+    wifi_stub_generate(count, 0);
+    alloc_track_reset();
+    size_t baseline = alloc_track_get().current;
+
+    pipeline_t pipeline;
+    if (pipeline_init(&pipeline) != 0) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    alloc_stats_t setup = alloc_track_get();
+
+    for (uint32_t scan = 0; scan < scans; scan++) {
+        wifi_stub_generate(count, scan + 1);
+        pipeline_run_scan(&pipeline, (int64_t)scan * 5000000);
+    }
+    alloc_stats_t done = alloc_track_get();
+
+    pipeline_ns_t const* ns      = &pipeline.ns;
+    double               records = pipeline.aps;
+    double               total   = ns->fetch + ns->cache + ns->topk + ns->format;
+    printf("%6u %6u %9.1f %9.1f %9.1f %9.1f %10.2f %9.3f %9zu %9zu %7u/%u\n", count, scans, ns->fetch / records,
+           ns->cache / records, ns->topk / records, ns->format / pipeline.lines, records / total * 1e3,
+           (double)(done.allocations - setup.allocations) / scans, setup.current - baseline, done.peak - baseline,
+           pipeline.cache.count, pipeline.cache.capacity);
+    pipeline_free(&pipeline);
+}
+
+int main(void) {
+    static uint16_t const sizes[] = {10, 100, 1000, 10000};
+
+    printf("Pipeline: top %d, fetch %d, chunk %d, AP table %u entries\n", PIPELINE_TOP_K, PIPELINE_FETCH_MAX,
+           PIPELINE_FETCH_CHUNK, 1u << PIPELINE_CACHE_LOG2);
+    printf("%6s %6s %9s %9s %9s %9s %10s %9s %9s %9s %11s\n", "APs", "scans", "fetch", "table", "topk", "format",
+           "M APs/s", "allocs", "setup B", "peak B", "table");
+    printf("%6s %6s %9s %9s %9s %9s %10s %9s %9s %9s %11s\n", "", "", "ns/AP", "ns/AP", "ns/AP", "ns/line", "",
+           "per scan", "", "", "");
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        run_size(sizes[i]);
+    }
+    wifi_stub_reset();
+    return 0;
+}
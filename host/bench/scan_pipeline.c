@@ -0,0 +1,77 @@
+#include "scan_pipeline.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ap_format.h"
+#include "esp_wifi.h"
+
+double pipeline_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int pipeline_init(pipeline_t* pipeline) {
+    memset(pipeline, 0, sizeof(*pipeline));
+    pipeline->cache_storage = calloc(1u << PIPELINE_CACHE_LOG2, sizeof(ap_cache_entry_t));
+    pipeline->topk_storage  = calloc(PIPELINE_TOP_K, sizeof(wifi_ap_record_t));
+    pipeline->fetched       = calloc(PIPELINE_FETCH_MAX, sizeof(wifi_ap_record_t));
+    if (!pipeline->cache_storage || !pipeline->topk_storage || !pipeline->fetched) {
+        pipeline_free(pipeline);
+        return -1;
+    }
+    ap_cache_init(&pipeline->cache, pipeline->cache_storage, 1u << PIPELINE_CACHE_LOG2, PIPELINE_CACHE_EWMA);
+    ap_topk_init(&pipeline->topk, pipeline->topk_storage, PIPELINE_TOP_K, ap_compare_rssi);
+    return 0;
+}
+
+void pipeline_free(pipeline_t* pipeline) {
+    free(pipeline->cache_storage);
+    free(pipeline->topk_storage);
+    free(pipeline->fetched);
+    pipeline->cache_storage = NULL;
+    pipeline->topk_storage  = NULL;
+    pipeline->fetched       = NULL;
+}
+
+static void merge_chunk(pipeline_t* pipeline, wifi_ap_record_t const* chunk, uint16_t count, int64_t now_us) {
+    double start = pipeline_now_ns();
+    for (uint16_t i = 0; i < count; i++) {
+        ap_cache_update(&pipeline->cache, &chunk[i], now_us);
+    }
+    double cached = pipeline_now_ns();
+    for (uint16_t i = 0; i < count; i++) {
+        ap_topk_offer(&pipeline->topk, &chunk[i]);
+    }
+    pipeline->ns.cache += cached - start;
+    pipeline->ns.topk  += pipeline_now_ns() - cached;
+    pipeline->aps      += count;
+}
+
+// Same fetch strategy as scan_fetch_records(): one bulk call, merged chunk by chunk
+void pipeline_run_scan(pipeline_t* pipeline, int64_t now_us) {
+    ap_topk_reset(&pipeline->topk);
+
+    double   start = pipeline_now_ns();
+    uint16_t total = 0;
+    esp_wifi_scan_get_ap_num(&total);
+    uint16_t count = total < PIPELINE_FETCH_MAX ? total : PIPELINE_FETCH_MAX;
+    esp_wifi_scan_get_ap_records(&count, pipeline->fetched);
+    pipeline->ns.fetch += pipeline_now_ns() - start;
+    for (uint16_t offset = 0; offset < count; offset += PIPELINE_FETCH_CHUNK) {
+        uint16_t length = count - offset < PIPELINE_FETCH_CHUNK ? count - offset : PIPELINE_FETCH_CHUNK;
+        merge_chunk(pipeline, &pipeline->fetched[offset], length, now_us);
+    }
+
+    start = pipeline_now_ns();
+    ap_topk_sort(&pipeline->topk);
+    pipeline->ns.topk += pipeline_now_ns() - start;
+
+    start = pipeline_now_ns();
+    char line[AP_FORMAT_LINE_MAX];
+    for (uint16_t i = 0; i < pipeline->topk.count; i++) {
+        pipeline->bytes += ap_format_record(line, sizeof(line), &pipeline->topk.records[i]);
+    }
+    pipeline->lines     += pipeline->topk.count;
+    pipeline->ns.format += pipeline_now_ns() - start;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdint.h>
+#include "ap_cache.h"
+#include "ap_topk.h"
+
+// The scan processing of wifi_scan.c, run against the stub scan API: fetch the records with
+// one call, merge them into the AP table chunk by chunk, keep the best K and format a log line per kept AP.
+// Sizes are the defaults of the matching CONFIG_WIFI_TEST_* options.
+#define PIPELINE_TOP_K       64
+#define PIPELINE_FETCH_MAX   128
+#define PIPELINE_FETCH_CHUNK 32
+#define PIPELINE_CACHE_LOG2  8
+#define PIPELINE_CACHE_EWMA  2
+
+typedef struct {
+    double fetch;
+    double cache;
+    double topk;
+    double format;
+} pipeline_ns_t;
+
+typedef struct {
+    ap_cache_t        cache;
+    ap_cache_entry_t* cache_storage;
+    ap_topk_t         topk;
+    wifi_ap_record_t* topk_storage;
+    wifi_ap_record_t* fetched;
+    pipeline_ns_t     ns;     // Time spent per stage
+    uint64_t          aps;    // Records fetched
+    uint64_t          lines;  // Lines formatted
+    uint64_t          bytes;  // Bytes formatted
+} pipeline_t;
+
+int  pipeline_init(pipeline_t* pipeline);
+void pipeline_free(pipeline_t* pipeline);
+
+// Process the records currently held by the stub scan API as one scan completed at now_us
+void pipeline_run_scan(pipeline_t* pipeline, int64_t now_us);
+
+double pipeline_now_ns(void);
@@ -0,0 +1,98 @@
+// Turns the console output of a build with CONFIG_BINLOG_OUTPUT_BINARY back into text:
+//   idf.py monitor | tee console.log; binlog_decode console.log
+// "#BL:" lines are decoded, everything else is passed through unchanged. Reads stdin when no
+// file is given.
+
+#include <stdio.h>
+#include <string.h>
+#include "binlog_codec.h"
+
+#define LINE_MAX_LENGTH 1024
+
+static int base64_value(char c) {
+    if (c >= 'A' && c <= 'Z') {
+        return c - 'A';
+    }
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a' + 26;
+    }
+    if (c >= '0' && c <= '9') {
+        return c - '0' + 52;
+    }
+    if (c == '+') {
+        return 62;
+    }
+    return c == '/' ? 63 : -1;
+}
+
+// Returns the number of bytes decoded, or -1 on anything that is not base64
+static int base64_decode(char const* text, uint8_t* out, size_t size) {
+    size_t   length = 0;
+    uint32_t bits   = 0;
+    int      count  = 0;
+    for (; *text && *text != '\r' && *text != '\n' && *text != '='; text++) {
+        int value = base64_value(*text);
+        if (value < 0) {
+            return -1;
+        }
+        bits = bits << 6 | value;
+        if (++count == 4) {
+            if (length + 3 > size) {
+                return -1;
+            }
+            out[length++] = bits >> 16;
+            out[length++] = bits >> 8;
+            out[length++] = bits;
+            bits          = 0;
+            count         = 0;
+        }
+    }
+    if (count == 1 || length + count - 1 > size) {
+        return -1;
+    }
+    if (count >= 2) {
+        bits <<= 6 * (4 - count);
+        out[length++] = bits >> 16;
+        if (count == 3) {
+            out[length++] = bits >> 8;
+        }
+    }
+    return length;
+}
+
+int main(int argc, char** argv) {
+    FILE* input = stdin;
+    if (argc > 1 && (input = fopen(argv[1], "r")) == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    char     line[LINE_MAX_LENGTH];
+    uint64_t decoded = 0;
+    uint64_t damaged = 0;
+    while (fgets(line, sizeof(line), input)) {
+        char* marker = strstr(line, "#BL:");
+        if (marker == NULL) {
+            fputs(line, stdout);
+            continue;
+        }
+        uint8_t record[BINLOG_RECORD_MAX];
+        char    text[BINLOG_RECORD_MAX + 128];
+        int     length = base64_decode(marker + 4, record, sizeof(record));
+        if (length < 0 || binlog_format(text, sizeof(text), record, length) < 0) {
+            damaged++;
+            fputs(line, stdout);
+            continue;
+        }
+        // Keep whatever the console printed before the record on the same line
+        fwrite(line, 1, marker - line, stdout);
+        puts(text);
+        decoded++;
+    }
+    fprintf(stderr, "%llu records decoded, %llu damaged\n", (unsigned long long)decoded,
+            (unsigned long long)damaged);
+    if (input != stdin) {
+        fclose(input);
+    }
+    return 0;
+}
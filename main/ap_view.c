@@ -0,0 +1,158 @@
+#include "ap_view.h"
+#include <stdio.h>
+#include <string.h>
+#include "ap_format.h"
+#include "ap_topk.h"
+#include "pax_fonts.h"
+#include "pax_text.h"
+
+#define AP_VIEW_FONT_SIZE  16
+#define AP_VIEW_SSID_CHARS 16  // Keeps the text clear of the sparkline
+
+// RSSI range covered by the height of a sparkline
+#define SPARK_RSSI_MIN (-95)
+#define SPARK_RSSI_MAX (-35)
+
+typedef struct {
+    char const*   name;
+    ap_compare_fn compare;
+} ap_view_sort_t;
+
+static ap_view_sort_t const sorts[] = {
+    {"RSSI", ap_compare_rssi},
+    {"SSID", ap_compare_ssid},
+    {"channel", ap_compare_channel},
+};
+
+esp_err_t ap_view_init(ap_view_t* view, fb_damage_t* damage, int x, int y, int width, int height,
+                       uint16_t capacity, pax_col_t fg, pax_col_t bg) {
+    memset(view, 0, sizeof(*view));
+    view->damage  = damage;
+    view->fg      = fg;
+    view->bg      = bg;
+    view->x       = x;
+    view->y       = y;
+    view->width   = width;
+    int rows      = width > AP_VIEW_SPARK_WIDTH ? height / AP_VIEW_ROW_HEIGHT - 1 : 0;
+    view->visible = rows < 0 ? 0 : rows > AP_VIEW_MAX_ROWS ? AP_VIEW_MAX_ROWS : rows;
+    for (uint16_t i = 0; i < AP_VIEW_MAX_ROWS; i++) {
+        view->drawn[i].row = UINT16_MAX;
+    }
+    if (view->visible == 0) {
+        return ESP_OK;  // Nothing will be drawn, the list is not needed
+    }
+    return ap_list_init(&view->list, capacity, sorts[0].compare);
+}
+
+static void view_clamp(ap_view_t* view) {
+    uint16_t last = view->list.count > view->visible ? view->list.count - view->visible : 0;
+    if (view->top > last) {
+        view->top = last;
+    }
+}
+
+void ap_view_sync(ap_view_t* view, ap_cache_t const* cache) {
+    ap_list_sync(&view->list, cache);
+    view_clamp(view);
+}
+
+void ap_view_sync_history(ap_view_t* view, ap_history_t const* history) {
+    for (uint16_t slot = 0; slot < view->visible; slot++) {
+        uint16_t                 position = view->top + slot;
+        ap_view_spark_t*         spark    = &view->sparks[slot];
+        ap_history_slot_t const* found    = NULL;
+        if (position < view->list.count) {
+            found = ap_history_find(history, ap_list_at(&view->list, position)->record.bssid);
+        }
+        if (found == NULL) {
+            spark->version = 0;
+            spark->count   = 0;
+        } else if (found->version != spark->version) {
+            spark->version = found->version;
+            spark->count   = ap_history_copy(found, spark->samples);
+        }
+    }
+}
+
+void ap_view_scroll(ap_view_t* view, int32_t rows) {
+    int32_t top = (int32_t)view->top + rows;
+    view->top   = top < 0 ? 0 : top > UINT16_MAX ? UINT16_MAX : top;
+    view_clamp(view);
+}
+
+void ap_view_next_sort(ap_view_t* view) {
+    view->sort = (view->sort + 1) % (sizeof(sorts) / sizeof(sorts[0]));
+    ap_list_set_compare(&view->list, sorts[view->sort].compare);
+}
+
+static void view_draw_header(ap_view_t* view) {
+    char     header[sizeof(view->header)];
+    uint16_t last = view->top + view->visible < view->list.count ? view->top + view->visible : view->list.count;
+    snprintf(header, sizeof(header), "%u APs by %s, %u-%u", view->list.count, sorts[view->sort].name,
+             view->list.count ? view->top + 1 : 0, last);
+    if (strcmp(header, view->header) == 0) {
+        return;
+    }
+    strcpy(view->header, header);
+    fb_damage_rect(view->damage, view->bg, view->x, view->y, view->width, AP_VIEW_ROW_HEIGHT);
+    fb_damage_text(view->damage, view->fg, pax_font_sky_mono, AP_VIEW_FONT_SIZE, view->x, view->y, header);
+}
+
+static void view_draw_row(ap_view_t* view, uint16_t slot, ap_list_row_t const* row) {
+    int y = view->y + (slot + 1) * AP_VIEW_ROW_HEIGHT;
+    fb_damage_rect(view->damage, view->bg, view->x, y, view->width - AP_VIEW_SPARK_WIDTH, AP_VIEW_ROW_HEIGHT);
+    if (row == NULL) {
+        return;
+    }
+    char                    text[80];
+    wifi_ap_record_t const* record = &row->record;
+    snprintf(text, sizeof(text), "%4d %3u %-13s %.*s", record->rssi, record->primary,
+             ap_format_auth_mode(record->authmode), AP_VIEW_SSID_CHARS,
+             record->ssid[0] ? (char const*)record->ssid : "<hidden>");
+    fb_damage_text(view->damage, view->fg, pax_font_sky_mono, AP_VIEW_FONT_SIZE, view->x, y, text);
+}
+
+// One bar per scan, scans the AP was missing from are left blank
+static void view_draw_spark(ap_view_t* view, uint16_t slot, ap_view_spark_t const* spark) {
+    int x = view->x + view->width - AP_VIEW_SPARK_WIDTH;
+    int y = view->y + (slot + 1) * AP_VIEW_ROW_HEIGHT;
+    fb_damage_rect(view->damage, view->bg, x, y, AP_VIEW_SPARK_WIDTH, AP_VIEW_ROW_HEIGHT);
+
+    int height = AP_VIEW_ROW_HEIGHT - 2;
+    int bar    = AP_VIEW_SPARK_WIDTH / AP_HISTORY_SAMPLES;
+    x          += (AP_HISTORY_SAMPLES - spark->count) * bar;  // Newest sample at the right edge
+    for (uint8_t i = 0; i < spark->count; i++, x += bar) {
+        int rssi = spark->samples[i];
+        if (rssi == AP_HISTORY_MISSING) {
+            continue;
+        }
+        rssi  = rssi < SPARK_RSSI_MIN ? SPARK_RSSI_MIN : rssi > SPARK_RSSI_MAX ? SPARK_RSSI_MAX : rssi;
+        int h = 1 + (rssi - SPARK_RSSI_MIN) * (height - 1) / (SPARK_RSSI_MAX - SPARK_RSSI_MIN);
+        fb_damage_rect(view->damage, view->fg, x, y + 1 + height - h, bar - 1 > 0 ? bar - 1 : 1, h);
+    }
+}
+
+void ap_view_render(ap_view_t* view) {
+    if (view->visible == 0) {
+        return;  // The region is too small to show anything
+    }
+    view_draw_header(view);
+    for (uint16_t slot = 0; slot < view->visible; slot++) {
+        uint16_t             position = view->top + slot;
+        ap_list_row_t const* row      = position < view->list.count ? ap_list_at(&view->list, position) : NULL;
+        uint16_t             index    = row ? view->list.order[position] : UINT16_MAX;
+        uint32_t             version  = row ? row->version : 0;
+        ap_view_slot_t*      drawn    = &view->drawn[slot];
+        ap_view_spark_t*     spark    = &view->sparks[slot];
+        if (drawn->row != index || drawn->history != spark->version) {
+            view_draw_spark(view, slot, spark);
+            drawn->history = spark->version;
+        }
+        if (drawn->row == index && drawn->version == version) {
+            continue;
+        }
+        view_draw_row(view, slot, row);
+        drawn->row     = index;
+        drawn->version = version;
+    }
+}
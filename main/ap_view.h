@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdint.h>
+#include "ap_cache.h"
+#include "ap_history.h"
+#include "ap_list.h"
+#include "esp_err.h"
+#include "fb_damage.h"
+#include "pax_gfx.h"
+
+#define AP_VIEW_ROW_HEIGHT  18
+#define AP_VIEW_MAX_ROWS    64
+#define AP_VIEW_SPARK_WIDTH (AP_HISTORY_SAMPLES * 2)  // Sparkline at the right end of every row
+
+typedef struct {
+    uint16_t row;      // List row drawn in this slot, UINT16_MAX when blank
+    uint32_t version;  // Version of that row when it was drawn
+    uint32_t history;  // Version of the sparkline when it was drawn
+} ap_view_slot_t;
+
+// RSSI history of the AP in a slot, copied out of the history table
+typedef struct {
+    uint32_t version;  // Of the history slot, 0 when the AP has no history
+    uint8_t  count;
+    int8_t   samples[AP_HISTORY_SAMPLES];
+} ap_view_spark_t;
+
+// Scrollable AP list in a region of the framebuffer. Only the rows that fit are drawn, and a
+// row is only repainted when a different AP or a newer version of the same AP lands in its slot.
+// The sparkline of a row is repainted on its own, when the RSSI history of its AP changed.
+typedef struct {
+    fb_damage_t*    damage;
+    pax_col_t       fg;
+    pax_col_t       bg;
+    int             x;
+    int             y;
+    int             width;
+    uint16_t        visible;  // Rows below the header
+    uint16_t        top;      // List position of the first visible row
+    uint8_t         sort;
+    ap_list_t       list;
+    ap_view_slot_t  drawn[AP_VIEW_MAX_ROWS];
+    ap_view_spark_t sparks[AP_VIEW_MAX_ROWS];
+    char            header[64];  // As last drawn
+} ap_view_t;
+
+// A region too small for a single row leaves visible at 0, such a view draws nothing and the
+// other calls must not be made
+esp_err_t ap_view_init(ap_view_t* view, fb_damage_t* damage, int x, int y, int width, int height,
+                       uint16_t capacity, pax_col_t fg, pax_col_t bg);
+
+// Merge the AP table, call with the table held
+void ap_view_sync(ap_view_t* view, ap_cache_t const* cache);
+
+// Copy the history of the visible rows, call with the table held after scrolling
+void ap_view_sync_history(ap_view_t* view, ap_history_t const* history);
+
+void ap_view_scroll(ap_view_t* view, int32_t rows);
+
+// Switch to the next sort key: RSSI, SSID, channel
+void ap_view_next_sort(ap_view_t* view);
+
+// Draw whatever changed since the previous call
+void ap_view_render(ap_view_t* view);
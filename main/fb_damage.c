@@ -0,0 +1,259 @@
+#include "fb_damage.h"
+#include <inttypes.h>
+#include <string.h>
+#include "bsp/display.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "fb_fill.h"
+
+// Merge two regions when their union wastes at most this many extra pixels
+#define MERGE_SLACK_PIXELS 4096
+
+static char const TAG[] = "fb_damage";
+
+static int rect_area(fb_rect_t const* rect) {
+    return rect->w * rect->h;
+}
+
+static fb_rect_t rect_union(fb_rect_t const* a, fb_rect_t const* b) {
+    int x0 = a->x < b->x ? a->x : b->x;
+    int y0 = a->y < b->y ? a->y : b->y;
+    int x1 = a->x + a->w > b->x + b->w ? a->x + a->w : b->x + b->w;
+    int y1 = a->y + a->h > b->y + b->h ? a->y + a->h : b->y + b->h;
+    return (fb_rect_t){x0, y0, x1 - x0, y1 - y0};
+}
+
+static bool rect_clip(fb_rect_t* rect, int width, int height) {
+    if (rect->x < 0) {
+        rect->w += rect->x;
+        rect->x = 0;
+    }
+    if (rect->y < 0) {
+        rect->h += rect->y;
+        rect->y = 0;
+    }
+    if (rect->x + rect->w > width) {
+        rect->w = width - rect->x;
+    }
+    if (rect->y + rect->h > height) {
+        rect->h = height - rect->y;
+    }
+    return rect->w > 0 && rect->h > 0;
+}
+
+esp_err_t fb_damage_init(fb_damage_t* damage, pax_buf_t* buf, size_t native_width, size_t native_height,
+                         bool reversed, fb_damage_policy_t const* policy, memstat_arena_t* arena) {
+    memset(damage, 0, sizeof(*damage));
+    damage->buf             = buf;
+    damage->native_width    = native_width;
+    damage->native_height   = native_height;
+    damage->bits_per_pixel  = PAX_GET_BPP(pax_buf_get_type(buf));
+    damage->bytes_per_pixel = damage->bits_per_pixel / 8;
+    damage->reversed        = reversed;
+    damage->arena           = arena;
+    damage->policy          = policy ? *policy : (fb_damage_policy_t)FB_DAMAGE_POLICY_DEFAULT();
+    if (damage->policy.stats_interval == 0) {
+        damage->policy.stats_interval = 1;
+    }
+    // Anything that does not fit a scratch buffer goes out as a full frame
+    size_t frame_size    = native_width * native_height * damage->bits_per_pixel / 8;
+    damage->scratch_size = frame_size * damage->policy.full_percent / 100;
+    if (damage->scratch_size == 0) {
+        return ESP_OK;
+    }
+    damage->scratch[0] = memstat_arena_alloc(arena, damage->scratch_size);
+    damage->scratch[1] = memstat_arena_alloc(arena, damage->scratch_size);
+    if (damage->scratch[0] == NULL || damage->scratch[1] == NULL) {
+        damage->scratch[0] = NULL;  // Partial updates need both
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void fb_damage_add(fb_damage_t* damage, int x, int y, int w, int h) {
+    fb_rect_t rect = {x, y, w, h};
+    if (!rect_clip(&rect, pax_buf_get_width(damage->buf), pax_buf_get_height(damage->buf))) {
+        return;
+    }
+
+    // Absorb every region the new one overlaps or cheaply merges with
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (uint8_t i = 0; i < damage->count; i++) {
+            fb_rect_t joined = rect_union(&rect, &damage->rects[i]);
+            if (rect_area(&joined) <= rect_area(&rect) + rect_area(&damage->rects[i]) + MERGE_SLACK_PIXELS) {
+                rect             = joined;
+                damage->rects[i] = damage->rects[--damage->count];
+                merged           = true;
+                break;
+            }
+        }
+    }
+
+    if (damage->count == FB_DAMAGE_MAX_RECTS) {
+        // Out of slots, grow whichever region grows least
+        uint8_t best      = 0;
+        int     best_cost = INT32_MAX;
+        for (uint8_t i = 0; i < damage->count; i++) {
+            fb_rect_t joined = rect_union(&rect, &damage->rects[i]);
+            int       cost   = rect_area(&joined) - rect_area(&damage->rects[i]);
+            if (cost < best_cost) {
+                best      = i;
+                best_cost = cost;
+            }
+        }
+        damage->rects[best] = rect_union(&rect, &damage->rects[best]);
+        return;
+    }
+    damage->rects[damage->count++] = rect;
+}
+
+void fb_damage_all(fb_damage_t* damage) {
+    damage->count    = 1;
+    damage->rects[0] = (fb_rect_t){0, 0, pax_buf_get_width(damage->buf), pax_buf_get_height(damage->buf)};
+}
+
+void fb_damage_rect(fb_damage_t* damage, pax_col_t color, int x, int y, int w, int h) {
+    fb_rect_t rect = {x, y, w, h};
+    fb_rect_t native;
+    if (damage->bytes_per_pixel == 0) {
+        pax_simple_rect(damage->buf, color, x, y, w, h);
+    } else if (fb_damage_native_rect(damage, &rect, &native)) {
+        uint32_t value = pax_col2buf(damage->buf, color);
+        if (damage->reversed) {
+            value = fb_fill_reverse(value, damage->bytes_per_pixel);
+        }
+        fb_fill_rect((void*)pax_buf_get_pixels(damage->buf), damage->native_width * damage->bytes_per_pixel, native.x,
+                     native.y, native.w, native.h, value, damage->bytes_per_pixel);
+    }
+    fb_damage_add(damage, x, y, w, h);
+}
+
+pax_vec2f fb_damage_text(fb_damage_t* damage, pax_col_t color, pax_font_t const* font, float font_size, int x, int y,
+                         char const* text) {
+    pax_vec2f size = pax_draw_text(damage->buf, color, font, font_size, x, y, text);
+    fb_damage_add(damage, x, y, (int)(size.x + 0.999f), (int)(size.y + 0.999f));
+    return size;
+}
+
+static void damage_blit_full(fb_damage_t* damage) {
+    bsp_display_blit(0, 0, damage->native_width, damage->native_height, pax_buf_get_pixels(damage->buf));
+    damage->bytes_pushed += (uint64_t)damage->native_width * damage->native_height * damage->bits_per_pixel / 8;
+}
+
+// Widen a panel rectangle to whole bytes, for formats that pack several pixels into one
+static void damage_align_rect(fb_damage_t const* damage, fb_rect_t* rect) {
+    int per_byte = damage->bits_per_pixel < 8 ? 8 / damage->bits_per_pixel : 1;
+    int x1       = (rect->x + rect->w + per_byte - 1) / per_byte * per_byte;
+    rect->x      = rect->x / per_byte * per_byte;
+    rect->w      = x1 - rect->x;
+    rect_clip(rect, damage->native_width, damage->native_height);
+}
+
+// Partial-width regions are packed at *offset in the scratch buffer, which is then advanced.
+// bsp_display_blit() may return before its DMA is done, so no scratch byte is reused within
+// one flush, and consecutive flushes pack into alternate buffers: a transfer has until the
+// flush after next to finish. A buffer holds the whole damaged area, or the frame goes out in full.
+static void damage_blit_rect(fb_damage_t* damage, fb_rect_t const* rect, uint8_t* scratch, size_t* offset) {
+    size_t         bits   = damage->bits_per_pixel;
+    size_t         stride = damage->native_width * bits / 8;
+    uint8_t const* pixels = pax_buf_get_pixels(damage->buf);
+    uint8_t const* origin = pixels + rect->y * stride + rect->x * bits / 8;
+    size_t         row    = rect->w * bits / 8;
+
+    if ((size_t)rect->w == damage->native_width) {
+        // Full-width rows are already contiguous in the framebuffer
+        bsp_display_blit(rect->x, rect->y, rect->w, rect->h, origin);
+    } else {
+        uint8_t* packed = scratch + *offset;
+        for (int line = 0; line < rect->h; line++) {
+            memcpy(packed + line * row, origin + line * stride, row);
+        }
+        bsp_display_blit(rect->x, rect->y, rect->w, rect->h, packed);
+        *offset += row * rect->h;
+    }
+    damage->bytes_pushed += row * rect->h;
+}
+
+bool fb_damage_native_rect(fb_damage_t const* damage, fb_rect_t const* rect, fb_rect_t* out) {
+    pax_recti oriented = pax_orient_det_recti(damage->buf, (pax_recti){rect->x, rect->y, rect->w, rect->h});
+    if (oriented.w < 0) {
+        oriented.x += oriented.w;
+        oriented.w = -oriented.w;
+    }
+    if (oriented.h < 0) {
+        oriented.y += oriented.h;
+        oriented.h = -oriented.h;
+    }
+    *out = (fb_rect_t){oriented.x, oriented.y, oriented.w, oriented.h};
+    return rect_clip(out, damage->native_width, damage->native_height);
+}
+
+static void damage_log_stats(fb_damage_t const* damage) {
+    uint64_t full    = (uint64_t)damage->native_width * damage->native_height * damage->bits_per_pixel / 8;
+    uint32_t updates = damage->full_updates + damage->partial_updates;
+    ESP_LOGI(TAG,
+             "%" PRIu32 " frames (%" PRIu32 " full, %" PRIu32 " partial), %" PRIu64
+             " bytes/frame pushed, full frame is %" PRIu64 " bytes, update avg %" PRId64 " us, max %" PRId64 " us",
+             damage->frames, damage->full_updates, damage->partial_updates, damage->bytes_pushed / damage->frames,
+             full, updates ? damage->update_us_sum / updates : 0, damage->update_us_max);
+}
+
+void fb_damage_flush(fb_damage_t* damage) {
+    if (damage->count == 0) {
+        return;
+    }
+
+    // Map the damage into panel coordinates
+    fb_rect_t native[FB_DAMAGE_MAX_RECTS];
+    uint8_t   count = 0;
+    for (uint8_t i = 0; i < damage->count; i++) {
+        if (fb_damage_native_rect(damage, &damage->rects[i], &native[count])) {
+            damage_align_rect(damage, &native[count]);
+            count++;
+        }
+    }
+    damage->count = 0;
+    if (count == 0) {
+        return;
+    }
+    if (damage->policy.single_region) {
+        for (uint8_t i = 1; i < count; i++) {
+            native[0] = rect_union(&native[0], &native[i]);
+        }
+        count = 1;
+    }
+    size_t area = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        area += rect_area(&native[i]);
+    }
+
+    bool full = damage->scratch[0] == NULL || area * damage->bits_per_pixel / 8 > damage->scratch_size ||
+                (damage->policy.full_every && damage->partial_since_full >= damage->policy.full_every);
+    int64_t start = esp_timer_get_time();
+    if (full) {
+        damage_blit_full(damage);
+        damage->full_updates++;
+        damage->partial_since_full = 0;
+    } else {
+        uint8_t* scratch = damage->scratch[damage->scratch_next];
+        size_t   offset  = 0;
+        damage->scratch_next ^= 1;
+        for (uint8_t i = 0; i < count; i++) {
+            damage_blit_rect(damage, &native[i], scratch, &offset);
+        }
+        damage->partial_updates++;
+        damage->partial_since_full++;
+    }
+    int64_t elapsed = esp_timer_get_time() - start;
+    damage->update_us_sum += elapsed;
+    if (elapsed > damage->update_us_max) {
+        damage->update_us_max = elapsed;
+    }
+
+    damage->frames++;
+    if (damage->frames % damage->policy.stats_interval == 0) {
+        damage_log_stats(damage);
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "memstat.h"
+#include "pax_gfx.h"
+
+#define FB_DAMAGE_MAX_RECTS 8
+
+typedef struct {
+    int x;
+    int y;
+    int w;
+    int h;
+} fb_rect_t;
+
+// How damage turns into display updates. Every update of an e-paper panel is a refresh that
+// takes hundreds of milliseconds, so there all damage goes out as a single region, and a full
+// refresh is forced now and then to clear the ghosting partial refreshes leave behind.
+typedef struct {
+    uint8_t  full_percent;    // Push the whole frame when more than this share of it changed
+    uint16_t full_every;      // Force a full update after this many partial ones, 0 for never
+    bool     single_region;   // Push the bounding box of all damage as one update
+    uint16_t stats_interval;  // Frames between stats log lines
+} fb_damage_policy_t;
+
+#define FB_DAMAGE_POLICY_DEFAULT() {.full_percent = 50, .full_every = 0, .single_region = false, .stats_interval = 64}
+
+// Tracks which parts of a framebuffer changed since the last flush, so only those are
+// pushed to the display. Rectangles are kept in drawing (oriented) coordinates.
+typedef struct {
+    pax_buf_t*         buf;
+    size_t             native_width;     // Panel resolution, before orientation
+    size_t             native_height;
+    size_t             bits_per_pixel;
+    size_t             bytes_per_pixel;  // 0 for sub-byte palette formats
+    bool               reversed;         // Pixels are stored byte-swapped (pax_buf_reversed)
+    fb_damage_policy_t policy;
+    memstat_arena_t*   arena;            // Scratch and text cache pixels, NULL for the heap
+    fb_rect_t          rects[FB_DAMAGE_MAX_RECTS];
+    uint8_t            count;
+    uint8_t*           scratch[2];       // Pack partial-width regions into contiguous rows, flushes alternate
+    size_t             scratch_size;     // Of each scratch buffer
+    uint8_t            scratch_next;     // Buffer the next partial flush packs into
+    uint32_t           frames;
+    uint32_t           full_updates;
+    uint32_t           partial_updates;
+    uint32_t           partial_since_full;
+    uint64_t           bytes_pushed;
+    int64_t            update_us_sum;    // Time spent in bsp_display_blit()
+    int64_t            update_us_max;    // Longest single frame
+} fb_damage_t;
+
+// A NULL policy means FB_DAMAGE_POLICY_DEFAULT()
+esp_err_t fb_damage_init(fb_damage_t* damage, pax_buf_t* buf, size_t native_width, size_t native_height,
+                         bool reversed, fb_damage_policy_t const* policy, memstat_arena_t* arena);
+
+void fb_damage_add(fb_damage_t* damage, int x, int y, int w, int h);
+void fb_damage_all(fb_damage_t* damage);
+
+// Drawing helpers that record what they touch. Rectangles are filled with the fb_fill kernels
+// when the format has whole bytes per pixel, the color is taken as opaque.
+void      fb_damage_rect(fb_damage_t* damage, pax_col_t color, int x, int y, int w, int h);
+pax_vec2f fb_damage_text(fb_damage_t* damage, pax_col_t color, pax_font_t const* font, float font_size, int x, int y,
+                         char const* text);
+
+// Map a rectangle in drawing coordinates to panel coordinates, clipped to the panel.
+// Returns false when nothing is left.
+bool fb_damage_native_rect(fb_damage_t const* damage, fb_rect_t const* rect, fb_rect_t* out);
+
+// Push the damaged regions to the display and reset the damage
+void fb_damage_flush(fb_damage_t* damage);
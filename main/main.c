@@ -1,23 +1,27 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
+#include "ap_format.h"
+#include "ap_view.h"
+#include "binlog.h"
 #include "bsp/device.h"
 #include "bsp/display.h"
 #include "bsp/input.h"
-#include "bsp/power.h"
 #include "bsp/led.h"
 #include "driver/gpio.h"
 #include "esp_err.h"
 #include "esp_event.h"
-#include "esp_hosted_custom.h"
+#include "esp_heap_caps.h"
 #include "esp_lcd_panel_ops.h"
 #include "esp_lcd_types.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "esp_wifi.h"
+#include "fb_damage.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/event_groups.h"
 #include "hal/lcd_types.h"
-#include "host/port/sdio_wrapper.h"
+#include "memstat.h"
 #include "nvs_flash.h"
 #include "pax_fonts.h"
 #include "pax_gfx.h"
@@ -25,352 +29,493 @@
 #include "portmacro.h"
 #include "regex.h"
 #include "sdkconfig.h"
+#include "text_cache.h"
+#include "trace.h"
 #include "wifi_connection.h"
-
-//Wifi stuff
-#define DEFAULT_SCAN_LIST_SIZE 20
+#include "wifi_remote.h"
+#include "wifi_scan.h"
+#include "wifi_warm_start.h"
 
 // Constants
 static char const TAG[] = "main";
 
+#if CONFIG_FREERTOS_NUMBER_OF_CORES > 1
+#define RADIO_TASK_CORE 1
+#else
+#define RADIO_TASK_CORE tskNO_AFFINITY
+#endif
+
 // Global variables
 static size_t                       display_h_res        = 0;
 static size_t                       display_v_res        = 0;
 static lcd_color_rgb_pixel_format_t display_color_format = LCD_COLOR_PIXEL_FORMAT_RGB565;
 static lcd_rgb_data_endian_t        display_data_endian  = LCD_RGB_DATA_ENDIAN_LITTLE;
 static pax_buf_t                    fb                   = {0};
+static fb_damage_t                  damage               = {0};
 static QueueHandle_t                input_event_queue    = NULL;
 
 #if defined(CONFIG_BSP_TARGET_KAMI)
 static pax_col_t palette[] = {0xffffffff, 0xff000000, 0xffff0000};  // white, black, red
 #endif
 
+#if defined(CONFIG_BSP_TARGET_KAMI)
+#define BLACK 0
+#define WHITE 1
+#define RED   2
+#else
+#define BLACK 0xFF000000
+#define WHITE 0xFFFFFFFF
+#define RED   0xFFFF0000
+#endif
+
+// Push everything drawn since the previous blit
 void blit(void) {
-    bsp_display_blit(0, 0, display_h_res, display_v_res, pax_buf_get_pixels(&fb));
+    trace_span_t span = trace_begin("blit");
+    fb_damage_flush(&damage);
+    trace_end(&span);
 }
 
-static bool initialized = false;
-
-bool wifi_remote_get_initialized(void) {
-    return initialized;
-}
+// Latest state of every input band. The input loop folds events in, render_task draws whatever
+// changed since its last frame, so a burst of events costs a single frame.
+#define UI_DIRTY_KEYBOARD   BIT0
+#define UI_DIRTY_NAVIGATION BIT1
+#define UI_DIRTY_ACTION     BIT2
+#define UI_DIRTY_SCANCODE   BIT3
+#define UI_DIRTY_AP_LIST    BIT4  // Scrolled or sort key changed
+#define UI_DIRTY_AP_TABLE   BIT5  // New scan results merged into the AP table
+
+// Input bands on the left, AP list on the right
+#define UI_BAND_WIDTH 300
+
+// Ctrl gives the F keys a second function, so every letter stays input for the keyboard band
+#define UI_MODIFIER_CTRL (BSP_INPUT_MODIFIER_CTRL_L | BSP_INPUT_MODIFIER_CTRL_R)
+
+#define RENDER_STATS_INTERVAL CONFIG_WIFI_TEST_RENDER_STATS_INTERVAL
+#define RENDER_ARENA_SIZE     (CONFIG_WIFI_TEST_RENDER_ARENA_KB * 1024)
+#if defined(CONFIG_SPIRAM)
+#define RENDER_ARENA_CAPS MALLOC_CAP_SPIRAM
+#else
+#define RENDER_ARENA_CAPS MALLOC_CAP_DEFAULT
+#endif
+#if defined(CONFIG_WIFI_TEST_RENDER_SINGLE_REGION)
+#define RENDER_SINGLE_REGION true
+#else
+#define RENDER_SINGLE_REGION false
+#endif
 
-static esp_err_t wifi_remote_verify_radio_ready(void) {
-    void* card = hosted_sdio_init();
-    if (card == NULL) {
-        ESP_LOGE(TAG, "Failed to initialize SDIO for radio");
-        return ESP_FAIL;
+typedef struct {
+    bsp_input_event_t keyboard;
+    bsp_input_event_t navigation;
+    bsp_input_event_t action;
+    bsp_input_event_t scancode;
+    int32_t           scroll;       // AP list rows to scroll by
+    uint8_t           sort_steps;   // Sort keys to advance the AP list by
+    uint32_t          dirty;
+    uint32_t          events;       // Events folded in since the last frame
+    uint32_t          queue_depth;  // Deepest input queue backlog since the last frame
+    int64_t           oldest_us;    // Arrival of the oldest event not yet on screen
+} ui_model_t;
+
+typedef struct {
+    uint32_t frames;
+    uint32_t events;
+    uint32_t max_events;
+    uint32_t max_queue_depth;
+    int64_t  latency_sum_us;
+    int64_t  latency_max_us;
+} render_stats_t;
+
+static ui_model_t      ui_model           = {0};
+static portMUX_TYPE    ui_model_lock      = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t    render_task_handle = NULL;
+static render_stats_t  render_stats       = {0};
+static ap_view_t       ap_view;
+static text_cache_t    labels;
+static memstat_arena_t render_arena;  // Framebuffer, damage scratch and label pixels
+
+static void ui_model_apply(bsp_input_event_t const* event, uint32_t dirty, int64_t now) {
+    taskENTER_CRITICAL(&ui_model_lock);
+    switch (event->type) {
+        case INPUT_EVENT_TYPE_KEYBOARD:
+            ui_model.keyboard = *event;
+            break;
+        case INPUT_EVENT_TYPE_NAVIGATION:
+            ui_model.navigation = *event;
+            break;
+        case INPUT_EVENT_TYPE_ACTION:
+            ui_model.action = *event;
+            break;
+        case INPUT_EVENT_TYPE_SCANCODE:
+            ui_model.scancode = *event;
+            break;
+        default:
+            break;
     }
-    esp_err_t res = hosted_sdio_card_init(NULL);
-    if (res == ESP_OK) {
-        ESP_LOGI(TAG, "Radio ready");
-    } else {
-        ESP_LOGI(TAG, "Radio not ready");
+    if (ui_model.events == 0) {
+        ui_model.oldest_us = now;
     }
-    return res;
+    ui_model.dirty |= dirty;
+    ui_model.events++;
+    taskEXIT_CRITICAL(&ui_model_lock);
 }
 
-esp_err_t wifi_remote_initialize(void) {
-    if (initialized) {
-        return ESP_OK;
-    }
-    ESP_LOGW(TAG, "Switching radio off...\r\n");
-    bsp_power_set_radio_state(BSP_POWER_RADIO_STATE_OFF);
-    vTaskDelay(pdMS_TO_TICKS(50));
-    ESP_LOGW(TAG, "Switching radio to application mode...\r\n");
-    bsp_power_set_radio_state(BSP_POWER_RADIO_STATE_APPLICATION);
-    vTaskDelay(pdMS_TO_TICKS(1000));
-    ESP_LOGW(TAG, "Testing connection to radio...\r\n");
-    if (wifi_remote_verify_radio_ready() != ESP_OK) {
-        return ESP_ERR_INVALID_STATE;
-    }
-    ESP_LOGW(TAG, "Starting ESP hosted...\r\n");
-    esp_hosted_host_init();
-    initialized = true;
-    return ESP_OK;
-}
-
-static void print_auth_mode(int authmode)
-{
-    switch (authmode) {
-    case WIFI_AUTH_OPEN:
-        ESP_LOGI(TAG, "Authmode \tWIFI_AUTH_OPEN");
-        break;
-    case WIFI_AUTH_OWE:
-        ESP_LOGI(TAG, "Authmode \tWIFI_AUTH_OWE");
-        break;
-    case WIFI_AUTH_WEP:
-        ESP_LOGI(TAG, "Authmode \tWIFI_AUTH_WEP");
-        break;
-    case WIFI_AUTH_WPA_PSK:
-        ESP_LOGI(TAG, "Authmode \tWIFI_AUTH_WPA_PSK");
-        break;
-    case WIFI_AUTH_WPA2_PSK:
-        ESP_LOGI(TAG, "Authmode \tWIFI_AUTH_WPA2_PSK");
-        break;
-    case WIFI_AUTH_WPA_WPA2_PSK:
-        ESP_LOGI(TAG, "Authmode \tWIFI_AUTH_WPA_WPA2_PSK");
-        break;
-    case WIFI_AUTH_ENTERPRISE:
-        ESP_LOGI(TAG, "Authmode \tWIFI_AUTH_ENTERPRISE");
-        break;
-    case WIFI_AUTH_WPA3_PSK:
-        ESP_LOGI(TAG, "Authmode \tWIFI_AUTH_WPA3_PSK");
-        break;
-    case WIFI_AUTH_WPA2_WPA3_PSK:
-        ESP_LOGI(TAG, "Authmode \tWIFI_AUTH_WPA2_WPA3_PSK");
-        break;
-    case WIFI_AUTH_WPA3_ENTERPRISE:
-        ESP_LOGI(TAG, "Authmode \tWIFI_AUTH_WPA3_ENTERPRISE");
-        break;
-    case WIFI_AUTH_WPA2_WPA3_ENTERPRISE:
-        ESP_LOGI(TAG, "Authmode \tWIFI_AUTH_WPA2_WPA3_ENTERPRISE");
-        break;
-    case WIFI_AUTH_WPA3_ENT_192:
-        ESP_LOGI(TAG, "Authmode \tWIFI_AUTH_WPA3_ENT_192");
-        break;
-    default:
-        ESP_LOGI(TAG, "Authmode \tWIFI_AUTH_UNKNOWN");
-        break;
+// Navigation keys that move through the AP list, folded in like any other input
+static void ui_model_list_input(bsp_input_navigation_key_t key) {
+    int32_t scroll = 0;
+    uint8_t sort   = 0;
+    switch (key) {
+        case BSP_INPUT_NAVIGATION_KEY_UP:
+            scroll = -1;
+            break;
+        case BSP_INPUT_NAVIGATION_KEY_DOWN:
+            scroll = 1;
+            break;
+        case BSP_INPUT_NAVIGATION_KEY_LEFT:
+            scroll = -(int32_t)ap_view.visible;
+            break;
+        case BSP_INPUT_NAVIGATION_KEY_RIGHT:
+            scroll = ap_view.visible;
+            break;
+        case BSP_INPUT_NAVIGATION_KEY_TAB:
+            sort = 1;
+            break;
+        default:
+            return;
     }
+    taskENTER_CRITICAL(&ui_model_lock);
+    ui_model.scroll     += scroll;
+    ui_model.sort_steps += sort;
+    ui_model.dirty      |= UI_DIRTY_AP_LIST;
+    taskEXIT_CRITICAL(&ui_model_lock);
 }
 
-static void print_cipher_type(int pairwise_cipher, int group_cipher)
-{
-    switch (pairwise_cipher) {
-    case WIFI_CIPHER_TYPE_NONE:
-        ESP_LOGI(TAG, "Pairwise Cipher \tWIFI_CIPHER_TYPE_NONE");
-        break;
-    case WIFI_CIPHER_TYPE_WEP40:
-        ESP_LOGI(TAG, "Pairwise Cipher \tWIFI_CIPHER_TYPE_WEP40");
-        break;
-    case WIFI_CIPHER_TYPE_WEP104:
-        ESP_LOGI(TAG, "Pairwise Cipher \tWIFI_CIPHER_TYPE_WEP104");
-        break;
-    case WIFI_CIPHER_TYPE_TKIP:
-        ESP_LOGI(TAG, "Pairwise Cipher \tWIFI_CIPHER_TYPE_TKIP");
-        break;
-    case WIFI_CIPHER_TYPE_CCMP:
-        ESP_LOGI(TAG, "Pairwise Cipher \tWIFI_CIPHER_TYPE_CCMP");
-        break;
-    case WIFI_CIPHER_TYPE_TKIP_CCMP:
-        ESP_LOGI(TAG, "Pairwise Cipher \tWIFI_CIPHER_TYPE_TKIP_CCMP");
-        break;
-    case WIFI_CIPHER_TYPE_AES_CMAC128:
-        ESP_LOGI(TAG, "Pairwise Cipher \tWIFI_CIPHER_TYPE_AES_CMAC128");
-        break;
-    case WIFI_CIPHER_TYPE_SMS4:
-        ESP_LOGI(TAG, "Pairwise Cipher \tWIFI_CIPHER_TYPE_SMS4");
-        break;
-    case WIFI_CIPHER_TYPE_GCMP:
-        ESP_LOGI(TAG, "Pairwise Cipher \tWIFI_CIPHER_TYPE_GCMP");
-        break;
-    case WIFI_CIPHER_TYPE_GCMP256:
-        ESP_LOGI(TAG, "Pairwise Cipher \tWIFI_CIPHER_TYPE_GCMP256");
-        break;
-    default:
-        ESP_LOGI(TAG, "Pairwise Cipher \tWIFI_CIPHER_TYPE_UNKNOWN");
-        break;
-    }
-
-    switch (group_cipher) {
-    case WIFI_CIPHER_TYPE_NONE:
-        ESP_LOGI(TAG, "Group Cipher \tWIFI_CIPHER_TYPE_NONE");
-        break;
-    case WIFI_CIPHER_TYPE_WEP40:
-        ESP_LOGI(TAG, "Group Cipher \tWIFI_CIPHER_TYPE_WEP40");
-        break;
-    case WIFI_CIPHER_TYPE_WEP104:
-        ESP_LOGI(TAG, "Group Cipher \tWIFI_CIPHER_TYPE_WEP104");
-        break;
-    case WIFI_CIPHER_TYPE_TKIP:
-        ESP_LOGI(TAG, "Group Cipher \tWIFI_CIPHER_TYPE_TKIP");
-        break;
-    case WIFI_CIPHER_TYPE_CCMP:
-        ESP_LOGI(TAG, "Group Cipher \tWIFI_CIPHER_TYPE_CCMP");
-        break;
-    case WIFI_CIPHER_TYPE_TKIP_CCMP:
-        ESP_LOGI(TAG, "Group Cipher \tWIFI_CIPHER_TYPE_TKIP_CCMP");
-        break;
-    case WIFI_CIPHER_TYPE_SMS4:
-        ESP_LOGI(TAG, "Group Cipher \tWIFI_CIPHER_TYPE_SMS4");
-        break;
-    case WIFI_CIPHER_TYPE_GCMP:
-        ESP_LOGI(TAG, "Group Cipher \tWIFI_CIPHER_TYPE_GCMP");
-        break;
-    case WIFI_CIPHER_TYPE_GCMP256:
-        ESP_LOGI(TAG, "Group Cipher \tWIFI_CIPHER_TYPE_GCMP256");
-        break;
-    default:
-        ESP_LOGI(TAG, "Group Cipher \tWIFI_CIPHER_TYPE_UNKNOWN");
-        break;
+// Wake the renderer for something other than input, it does not count towards input latency
+static void ui_model_mark(uint32_t dirty) {
+    taskENTER_CRITICAL(&ui_model_lock);
+    ui_model.dirty |= dirty;
+    taskEXIT_CRITICAL(&ui_model_lock);
+    if (render_task_handle != NULL) {
+        xTaskNotifyGive(render_task_handle);
     }
 }
 
-static void wifi_scan(void)
-{
-    ESP_LOGI(TAG, "************* Before init netif *************");
-    ESP_ERROR_CHECK(esp_netif_init());
-    ESP_LOGI(TAG, "************* Netif init, before loop create *************");
-    ESP_ERROR_CHECK(esp_event_loop_create_default());
-    ESP_LOGI(TAG, "************* Loop created. Before getting defailt wifi sta *************");
-    esp_netif_t *sta_netif = esp_netif_create_default_wifi_sta();
-    assert(sta_netif);
-    ESP_LOGI(TAG, "************* Got sta_netif. Before wifi cfg init *************");
-
-    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
-    esp_err_t err = esp_wifi_init(&cfg);
-    if (err != ESP_OK) {
-        printf("ERROR configuring wifi %d\n", err);
-        return;
-    }
-    // ESP_ERROR_CHECK(esp_wifi_init(&cfg));
-
-    ESP_LOGI(TAG, "************* Wifi CFG ok. Before setting mode *************");
-
-    uint16_t number = DEFAULT_SCAN_LIST_SIZE;
-    wifi_ap_record_t ap_info[DEFAULT_SCAN_LIST_SIZE];
-    uint16_t ap_count = 0;
-    memset(ap_info, 0, sizeof(ap_info));
-
-
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
-    ESP_LOGI(TAG, "************* Set mode done. Before starting wifi *************");
-    ESP_ERROR_CHECK(esp_wifi_start());
-    ESP_LOGI(TAG, "************* Wifi started. Before scanning *************");
-
-// #ifdef USE_CHANNEL_BITMAP
-//     wifi_scan_config_t *scan_config = (wifi_scan_config_t *)calloc(1,sizeof(wifi_scan_config_t));
-//     if (!scan_config) {
-//         ESP_LOGE(TAG, "Memory Allocation for scan config failed!");
-//         return;
-//     }
-//     array_2_channel_bitmap(channel_list, CHANNEL_LIST_SIZE, scan_config);
-//     esp_wifi_scan_start(scan_config, true);
-//     free(scan_config);
-
-// #else
-    esp_wifi_scan_start(NULL, true);
-// #endif /*USE_CHANNEL_BITMAP*/
-
-    ESP_LOGI(TAG, "Max AP number ap_info can hold = %u", number);
-    ESP_ERROR_CHECK(esp_wifi_scan_get_ap_num(&ap_count));
-    ESP_ERROR_CHECK(esp_wifi_scan_get_ap_records(&number, ap_info));
-    ESP_LOGI(TAG, "Total APs scanned = %u, actual AP number ap_info holds = %u", ap_count, number);
-    for (int i = 0; i < number; i++) {
-        ESP_LOGI(TAG, "SSID \t\t%s", ap_info[i].ssid);
-        ESP_LOGI(TAG, "RSSI \t\t%d", ap_info[i].rssi);
-        print_auth_mode(ap_info[i].authmode);
-        if (ap_info[i].authmode != WIFI_AUTH_WEP) {
-            print_cipher_type(ap_info[i].pairwise_cipher, ap_info[i].group_cipher);
+static void scan_log_task(void* arg) {
+    QueueHandle_t      queue = arg;
+    wifi_scan_result_t result;
+    while (1) {
+        if (xQueueReceive(queue, &result, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        if (result.status != ESP_OK) {
+            ESP_LOGE(TAG, "Scan %" PRIu32 " failed: %s", result.sequence, esp_err_to_name(result.status));
+            continue;
+        }
+        BINLOG(SCAN_DONE, result.sequence, result.duration_us / 1000, result.total, result.count);
+        char line[AP_FORMAT_LINE_MAX];
+        for (uint16_t i = 0; i < result.count; i++) {
+            ap_format_record(line, sizeof(line), &result.records[i]);
+            BINLOG(SCAN_AP, line);
         }
-        ESP_LOGI(TAG, "Channel \t\t%d", ap_info[i].primary);
+        wifi_scan_result_release(&result);
+
+        ap_cache_t* cache = wifi_scan_cache_acquire();
+        if (cache) {
+            BINLOG(SCAN_TABLE, cache->count, cache->inserted, cache->evicted);
+            ap_history_t const* history = wifi_scan_history();
+            BINLOG(SCAN_HISTORY, history->count, history->updated, history->dropped);
+            wifi_scan_cache_release();
+        }
+        ui_model_mark(UI_DIRTY_AP_TABLE);
     }
 }
 
-static inline void wifi_desc_record(wifi_ap_record_t* record) {
-    // Make a string representation of BSSID.
-    char* bssid_str = malloc(3 * 6);
-    if (!bssid_str) return;
-    snprintf(bssid_str, 3 * 6, "%02X:%02X:%02X:%02X:%02X:%02X", record->bssid[0], record->bssid[1], record->bssid[2],
-             record->bssid[3], record->bssid[4], record->bssid[5]);
-
-    // Make a string representation of 11b/g/n modes.
-    char* phy_str = malloc(9);
-    if (!phy_str) {
-        free(bssid_str);
+// Brings up the radio and everything that depends on it, while app_main gets the display going
+static void radio_task(void* arg) {
+    if (wifi_remote_initialize() != ESP_OK) {
+        ESP_LOGE(TAG, "WiFi stack not initialized, cannot scan");
+        memstat_task_exit();
         return;
     }
-    *phy_str = 0;
-    if (record->phy_11b | record->phy_11g | record->phy_11n) {
-        strcpy(phy_str, " 1");
+    ESP_LOGI(TAG, "WiFi stack initialized %" PRId64 " ms after boot", esp_timer_get_time() / 1000);
+
+    // Scans run on their own task, results are picked up by scan_log_task. The first scan
+    // starts after the warm start connection attempt.
+    QueueHandle_t scan_result_queue = NULL;
+    esp_err_t     res               = wifi_scan_engine_start(&scan_result_queue);
+    if (res != ESP_OK) {
+        ESP_LOGE(TAG, "Scan engine not started, cannot scan: %s", esp_err_to_name(res));
+        memstat_task_exit();
+        return;
     }
-    if (record->phy_11b) {
-        strcat(phy_str, "/b");
+    if (memstat_task_create(scan_log_task, "scan_log", 4096, scan_result_queue, 2, NULL, tskNO_AFFINITY) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to start the scan log task, scan results are not logged");
     }
-    if (record->phy_11g) {
-        strcat(phy_str, "/g");
+    res = wifi_warm_start_begin();
+    if (res != ESP_OK) {
+        // The warm start would have asked for the first scan
+        ESP_LOGE(TAG, "Warm start not started, not connecting: %s", esp_err_to_name(res));
+        wifi_scan_request();
     }
-    if (record->phy_11n) {
-        strcat(phy_str, "/n");
+    memstat_task_exit();
+}
+
+static void handle_input_event(bsp_input_event_t const* event, int64_t now) {
+    switch (event->type) {
+        case INPUT_EVENT_TYPE_KEYBOARD: {
+            if (event->args_keyboard.ascii != '\b' ||
+                event->args_keyboard.ascii != '\t') {  // Ignore backspace & tab keyboard events
+                BINLOG(INPUT_KEYBOARD, event->args_keyboard.ascii, (uint8_t)event->args_keyboard.ascii,
+                       event->args_keyboard.utf8);
+                ui_model_apply(event, UI_DIRTY_KEYBOARD, now);
+            }
+            break;
+        }
+        case INPUT_EVENT_TYPE_NAVIGATION: {
+            BINLOG(INPUT_NAVIGATION, (uint32_t)event->args_navigation.key,
+                   event->args_navigation.state ? "pressed" : "released");
+
+            if (event->args_navigation.key == BSP_INPUT_NAVIGATION_KEY_F1) {
+                bsp_device_restart_to_launcher();
+            }
+            if (event->args_navigation.key == BSP_INPUT_NAVIGATION_KEY_F2) {
+                bsp_input_set_backlight_brightness(0);
+            }
+            if (event->args_navigation.key == BSP_INPUT_NAVIGATION_KEY_F3) {
+                bsp_input_set_backlight_brightness(100);
+            }
+            bool ctrl = (event->args_navigation.modifiers & UI_MODIFIER_CTRL) != 0;
+            if (event->args_navigation.key == BSP_INPUT_NAVIGATION_KEY_F4 && event->args_navigation.state && !ctrl) {
+                wifi_scan_request();
+            }
+            if (event->args_navigation.key == BSP_INPUT_NAVIGATION_KEY_F4 && event->args_navigation.state && ctrl) {
+                bool enable = !wifi_scan_background_enabled();
+                if (wifi_scan_set_background(enable) == ESP_OK) {
+                    ESP_LOGI(TAG, "Background scanning %s", enable ? "on" : "off");
+                }
+            }
+            if (event->args_navigation.key == BSP_INPUT_NAVIGATION_KEY_F5 && event->args_navigation.state) {
+                wifi_scan_request_benchmark();
+            }
+            if (event->args_navigation.key == BSP_INPUT_NAVIGATION_KEY_F6 && event->args_navigation.state && !ctrl) {
+                if (trace_dump_start() != ESP_OK) {
+                    ESP_LOGW(TAG, "Trace dump not available");
+                }
+            }
+            if (event->args_navigation.key == BSP_INPUT_NAVIGATION_KEY_F6 && event->args_navigation.state && ctrl) {
+                memstat_report_request();
+            }
+            if (event->args_navigation.state) {
+                ui_model_list_input(event->args_navigation.key);
+            }
+            ui_model_apply(event, UI_DIRTY_NAVIGATION, now);
+            break;
+        }
+        case INPUT_EVENT_TYPE_ACTION: {
+            BINLOG(INPUT_ACTION, (uint32_t)event->args_action.type, event->args_action.state ? "yes" : "no");
+            ui_model_apply(event, UI_DIRTY_ACTION, now);
+            break;
+        }
+        case INPUT_EVENT_TYPE_SCANCODE: {
+            BINLOG(INPUT_SCANCODE, (uint32_t)event->args_scancode.scancode);
+            ui_model_apply(event, UI_DIRTY_SCANCODE, now);
+            break;
+        }
+        default:
+            break;
     }
-    phy_str[2] = '1';
+}
+
+// A static label followed by a value that changes with every event
+static void render_field(int y, char const* label, char const* value) {
+    pax_vec2f size = text_cache_draw(&labels, BLACK, 0, y, label);
+    fb_damage_text(&damage, BLACK, pax_font_sky_mono, 16, size.x, y, value);
+}
+
+static void render_keyboard(bsp_input_event_t const* event) {
+    fb_damage_rect(&damage, WHITE, 0, 0, UI_BAND_WIDTH, 72);
+    text_cache_draw(&labels, BLACK, 0, 0, "Keyboard event");
+    char text[64];
+    snprintf(text, sizeof(text), "%c (0x%02x)", event->args_keyboard.ascii, (uint8_t)event->args_keyboard.ascii);
+    render_field(18, "ASCII:     ", text);
+    snprintf(text, sizeof(text), "%s", event->args_keyboard.utf8);
+    render_field(36, "UTF-8:     ", text);
+    snprintf(text, sizeof(text), "0x%0" PRIX32, event->args_keyboard.modifiers);
+    render_field(54, "Modifiers: ", text);
+}
+
+static void render_navigation(bsp_input_event_t const* event) {
+    fb_damage_rect(&damage, WHITE, 0, 100, UI_BAND_WIDTH, 72);
+    text_cache_draw(&labels, BLACK, 0, 100 + 0, "Navigation event");
+    char text[64];
+    snprintf(text, sizeof(text), "0x%0" PRIX32, (uint32_t)event->args_navigation.key);
+    render_field(100 + 18, "Key:       ", text);
+    render_field(100 + 36, "State:     ", event->args_navigation.state ? "pressed" : "released");
+    snprintf(text, sizeof(text), "0x%0" PRIX32, event->args_navigation.modifiers);
+    render_field(100 + 54, "Modifiers: ", text);
+}
+
+static void render_action(bsp_input_event_t const* event) {
+    fb_damage_rect(&damage, WHITE, 0, 200 + 0, UI_BAND_WIDTH, 72);
+    text_cache_draw(&labels, BLACK, 0, 200 + 0, "Action event");
+    char text[64];
+    snprintf(text, sizeof(text), "0x%0" PRIX32, (uint32_t)event->args_action.type);
+    render_field(200 + 36, "Type:      ", text);
+    render_field(200 + 54, "State:     ", event->args_action.state ? "yes" : "no");
+}
 
-    printf("AP %s %s rssi=%hhd%s\r\n", bssid_str, record->ssid, record->rssi, phy_str);
-    free(bssid_str);
-    free(phy_str);
+static void render_scancode(bsp_input_event_t const* event) {
+    fb_damage_rect(&damage, WHITE, 0, 300 + 0, UI_BAND_WIDTH, 72);
+    text_cache_draw(&labels, BLACK, 0, 300 + 0, "Scancode event");
+    char text[64];
+    snprintf(text, sizeof(text), "0x%0" PRIX32, (uint32_t)event->args_scancode.scancode);
+    render_field(300 + 36, "Scancode:  ", text);
 }
 
-static esp_err_t scan_for_networks(wifi_ap_record_t** out_aps, uint16_t* out_aps_length) {
-    if (wifi_remote_get_initialized()) {
-        esp_err_t res;
-
-        wifi_config_t wifi_config = {0};
-        ESP_LOGI(TAG, "************* Stopping Wifi *************");
-        ESP_RETURN_ON_ERROR(esp_wifi_stop(), TAG, "Failed to stop WiFi");
-        ESP_LOGI(TAG, "************* Setting Wifi mode *************");
-        ESP_RETURN_ON_ERROR(esp_wifi_set_mode(WIFI_MODE_STA), TAG, "Failed to set WiFi mode");
-        ESP_LOGI(TAG, "************* Configuring Wifi *************");
-        ESP_RETURN_ON_ERROR(esp_wifi_set_config(WIFI_IF_STA, &wifi_config), TAG, "Failed to set WiFi configuration");
-        ESP_LOGI(TAG, "************* Starting Wifi *************");
-        ESP_RETURN_ON_ERROR(esp_wifi_start(), TAG, "Failed to start WiFi");
-
-        // esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_SCAN_DONE, wifi_scan_done_handler, NULL);
-        wifi_scan_config_t cfg = {
-            .ssid      = NULL,
-            .bssid     = NULL,
-            .channel   = 0,
-            .scan_type = WIFI_SCAN_TYPE_ACTIVE,
-            .scan_time = {.active = {0, 0}},
-        };
-        res = esp_wifi_scan_start(&cfg, true);
-        if (res != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to start scan");
-            return res;
+#if CONFIG_WIFI_TEST_TEXT_BENCHMARK
+// Cost of drawing every input band, with the labels from the cache and with PAX alone. Runs
+// before the first frame, the framebuffer is cleared afterwards.
+static void text_benchmark(void) {
+    static char const* const modes[] = {"PAX", "cached"};
+    bsp_input_event_t        event   = {0};
+    for (int cached = 0; cached < 2; cached++) {
+        labels.bypass = !cached;
+        labels.hits   = 0;
+        int64_t start = esp_timer_get_time();
+        for (uint32_t round = 0; round < CONFIG_WIFI_TEST_TEXT_BENCHMARK_ROUNDS; round++) {
+            render_keyboard(&event);
+            render_navigation(&event);
+            render_action(&event);
+            render_scancode(&event);
         }
+        int64_t elapsed = esp_timer_get_time() - start;
+        ESP_LOGI(TAG, "Text benchmark (%s): %" PRId64 " us to draw all input bands, %" PRIu32 " cache hits",
+                 modes[cached], elapsed / CONFIG_WIFI_TEST_TEXT_BENCHMARK_ROUNDS, labels.hits);
+    }
+    labels.bypass = false;
+}
+#endif
 
-        uint16_t num_ap = 0;
-        res             = esp_wifi_scan_get_ap_num(&num_ap);
-        if (res != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to get number of APs");
-            return res;
+static void render_ap_list(ui_model_t const* model) {
+    if (ap_view.visible == 0) {
+        return;  // Not shown on this display
+    }
+    if (model->dirty & UI_DIRTY_AP_TABLE) {
+        ap_cache_t* cache = wifi_scan_cache_acquire();
+        if (cache) {
+            ap_view_sync(&ap_view, cache);
+            wifi_scan_cache_release();
         }
+    }
+    for (uint8_t i = 0; i < model->sort_steps; i++) {
+        ap_view_next_sort(&ap_view);
+    }
+    ap_view_scroll(&ap_view, model->scroll);
+    if (wifi_scan_cache_acquire()) {
+        ap_view_sync_history(&ap_view, wifi_scan_history());
+        wifi_scan_cache_release();
+    }
+    ap_view_render(&ap_view);
+}
 
-        printf("Found %u APs\r\n", num_ap);
+static void render_stats_update(ui_model_t const* model, int64_t now) {
+    render_stats_t* stats   = &render_stats;
+    int64_t         latency = now - model->oldest_us;
+    stats->frames++;
+    stats->events         += model->events;
+    stats->latency_sum_us += latency;
+    if (model->events > stats->max_events) {
+        stats->max_events = model->events;
+    }
+    if (model->queue_depth > stats->max_queue_depth) {
+        stats->max_queue_depth = model->queue_depth;
+    }
+    if (latency > stats->latency_max_us) {
+        stats->latency_max_us = latency;
+    }
+    if (stats->frames < RENDER_STATS_INTERVAL) {
+        return;
+    }
+    ESP_LOGI(TAG,
+             "%" PRIu32 " frames: %" PRIu32 ".%" PRIu32 " events/frame (max %" PRIu32 "), queue depth max %" PRIu32
+             ", input to photon avg %" PRId64 " us, max %" PRId64 " us",
+             stats->frames, stats->events / stats->frames, (stats->events * 10 / stats->frames) % 10,
+             stats->max_events, stats->max_queue_depth, stats->latency_sum_us / stats->frames,
+             stats->latency_max_us);
+    memset(stats, 0, sizeof(*stats));
+}
 
-        wifi_ap_record_t* aps = malloc(sizeof(wifi_ap_record_t) * num_ap);
-        if (!aps) {
-            ESP_LOGE(TAG, "Out of memory (failed to allocate %zd bytes)", sizeof(wifi_ap_record_t) * num_ap);
-            num_ap = 0;
-            esp_wifi_scan_get_ap_records(&num_ap, NULL);
-            return ESP_ERR_NO_MEM;
-        }
+// Draw what changed in the model. Returns when the frame went out, 0 when nothing had changed.
+// Latency is measured from the moment the input loop took the oldest event of a frame off the
+// queue until the blit returned.
+static int64_t render_frame(void) {
+    taskENTER_CRITICAL(&ui_model_lock);
+    ui_model_t model     = ui_model;
+    ui_model.dirty       = 0;
+    ui_model.events      = 0;
+    ui_model.queue_depth = 0;
+    ui_model.scroll      = 0;
+    ui_model.sort_steps  = 0;
+    taskEXIT_CRITICAL(&ui_model_lock);
+    if (model.dirty == 0) {
+        return 0;  // Already drawn by the previous frame
+    }
+
+    if (model.dirty & UI_DIRTY_KEYBOARD) {
+        render_keyboard(&model.keyboard);
+    }
+    if (model.dirty & UI_DIRTY_NAVIGATION) {
+        render_navigation(&model.navigation);
+    }
+    if (model.dirty & UI_DIRTY_ACTION) {
+        render_action(&model.action);
+    }
+    if (model.dirty & UI_DIRTY_SCANCODE) {
+        render_scancode(&model.scancode);
+    }
+    if (model.dirty & (UI_DIRTY_AP_LIST | UI_DIRTY_AP_TABLE)) {
+        render_ap_list(&model);
+    }
+    blit();
+    int64_t now = esp_timer_get_time();
+    if (model.events > 0) {
+        render_stats_update(&model, now);
+    }
+    return now;
+}
+
+// Draws at most one frame per display refresh interval
+static void render_task(void* arg) {
+    int64_t const interval_us   = CONFIG_WIFI_TEST_RENDER_INTERVAL_MS * 1000;
+    int64_t       last_frame_us = 0;
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 
-        res = esp_wifi_scan_get_ap_records(&num_ap, aps);
-        if (res != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to fetch AP records");
-            free(aps);
-            return res;
+        // Slow panels hold the first change back a little so a burst of input is one refresh
+        if (CONFIG_WIFI_TEST_RENDER_MERGE_WINDOW_MS > 0) {
+            vTaskDelay(pdMS_TO_TICKS(CONFIG_WIFI_TEST_RENDER_MERGE_WINDOW_MS));
         }
 
-        for (uint16_t i = 0; i < num_ap; i++) {
-            wifi_desc_record(&aps[i]);
+        // Events arriving while we wait for the next refresh slot end up in this frame
+        int64_t wait_us = last_frame_us + interval_us - esp_timer_get_time();
+        if (wait_us > 0) {
+            vTaskDelay((wait_us * configTICK_RATE_HZ + 999999) / 1000000);
         }
 
-        if (out_aps) {
-            *out_aps        = aps;
-            *out_aps_length = num_ap;
-        } else {
-            free(aps);
+        int64_t frame_us = render_frame();
+        if (frame_us != 0) {
+            last_frame_us = frame_us;
         }
-    } else {
-        printf("WiFi stack not initialized\nThe WiFi stack is not initialized. Please try again later.\n");
-        return ESP_ERR_NOT_FOUND;
     }
-    return ESP_OK;
 }
 
 void app_main(void) {
+    // Arena usage, heap fragmentation and stack watermarks are logged by a low priority task
+    memstat_task_register(xTaskGetCurrentTaskHandle(), "main", CONFIG_ESP_MAIN_TASK_STACK_SIZE);
+    ESP_ERROR_CHECK(memstat_start());
+
+    // Hot paths log through the binary log ring, drained by a low priority task
+    ESP_ERROR_CHECK(binlog_init());
+
     // Start the GPIO interrupt service
     gpio_install_isr_service(0);
 
@@ -382,39 +527,16 @@ void app_main(void) {
     }
     ESP_ERROR_CHECK(res);
 
-    ESP_LOGI(TAG, "************* Before WiFi stack initialize.... *************");
-    if (!(wifi_remote_initialize() == ESP_OK)) {
-        ESP_LOGE(TAG, "WiFi stack not initialized, cannot scan");
-        vTaskDelay(2000 / portTICK_PERIOD_MS);
-        return;
+    // The radio takes about a second to boot, do that on the other core
+    wifi_remote_power_on();
+    if (memstat_task_create(radio_task, "radio", 4096, NULL, 5, NULL, RADIO_TASK_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to start the radio task, running without WiFi");
     }
-    ESP_LOGI(TAG, "WiFi stack initialized, can scan");
-
-    // esp_wifi_scan_start(NULL, true);
-    // uint16_t ap_count = 0;
-    // wifi_ap_record_t ap_info[DEFAULT_SCAN_LIST_SIZE];
-    // memset(ap_info, 0, sizeof(ap_info));
-    // ESP_ERROR_CHECK(esp_wifi_scan_get_ap_num(&ap_count));
-    // ESP_ERROR_CHECK(esp_wifi_scan_get_ap_records(&number, ap_info));
-    // ESP_LOGI(TAG, "Total APs scanned = %u, actual AP number ap_info holds = %u", ap_count, number);
-    // for (int i = 0; i < number; i++) {
-    //     ESP_LOGI(TAG, "SSID \t\t%s", ap_info[i].ssid);
-    //     ESP_LOGI(TAG, "RSSI \t\t%d", ap_info[i].rssi);
-    //     print_auth_mode(ap_info[i].authmode);
-    //     if (ap_info[i].authmode != WIFI_AUTH_WEP) {
-    //         print_cipher_type(ap_info[i].pairwise_cipher, ap_info[i].group_cipher);
-    //     }
-    //     ESP_LOGI(TAG, "Channel \t\t%d", ap_info[i].primary);
-    // }
-
-    wifi_scan();
-
-    // wifi_ap_record_t* aps     = NULL;
-    // uint16_t          num_aps = 0;
-    // res     = scan_for_networks(&aps, &num_aps);
 
     // Initialize the Board Support Package
+    trace_span_t span = trace_begin("bsp_device_initialize");
     ESP_ERROR_CHECK(bsp_device_initialize());
+    trace_end(&span);
     bsp_led_initialize();
 
     uint8_t led_data[] = {
@@ -463,7 +585,14 @@ void app_main(void) {
     format = PAX_BUF_2_PAL;
 #endif
 
-    pax_buf_init(&fb, NULL, display_h_res, display_v_res, format);
+    // Everything the renderer keeps for its lifetime comes out of one fixed budget
+    memstat_arena_init(&render_arena, "render", RENDER_ARENA_SIZE, RENDER_ARENA_CAPS);
+    size_t fb_size   = (display_h_res * display_v_res * PAX_GET_BPP(format) + 7) / 8;
+    void*  fb_pixels = memstat_arena_alloc(&render_arena, fb_size);
+
+    span = trace_begin("pax_buf_init");
+    pax_buf_init(&fb, fb_pixels, display_h_res, display_v_res, format);
+    trace_end(&span);
     pax_buf_reversed(&fb, display_data_endian == LCD_RGB_DATA_ENDIAN_BIG);
 
 #if defined(CONFIG_BSP_TARGET_KAMI)
@@ -471,102 +600,67 @@ void app_main(void) {
     fb.palette_size = sizeof(palette) / sizeof(pax_col_t);
 #endif
 
-#if defined(CONFIG_BSP_TARGET_KAMI)
-#define BLACK 0
-#define WHITE 1
-#define RED   2
-#else
-#define BLACK 0xFF000000
-#define WHITE 0xFFFFFFFF
-#define RED   0xFFFF0000
-#endif
-
     pax_buf_set_orientation(&fb, orientation);
+    fb_damage_policy_t policy = {
+        .full_percent   = CONFIG_WIFI_TEST_RENDER_FULL_PERCENT,
+        .full_every     = CONFIG_WIFI_TEST_RENDER_FULL_EVERY,
+        .single_region  = RENDER_SINGLE_REGION,
+        .stats_interval = RENDER_STATS_INTERVAL,
+    };
+    ESP_ERROR_CHECK(fb_damage_init(&damage, &fb, display_h_res, display_v_res,
+                                   display_data_endian == LCD_RGB_DATA_ENDIAN_BIG, &policy, &render_arena));
+    text_cache_init(&labels, &damage, pax_font_sky_mono, 16, WHITE);
+    // The AP list takes the space right of the input bands, which narrow displays do not have
+    int ap_view_width = pax_buf_get_width(&fb) - UI_BAND_WIDTH;
+    if (ap_view_width <= AP_VIEW_SPARK_WIDTH) {
+        ESP_LOGW(TAG, "Display too narrow for the AP list");
+        ap_view_width = 0;
+    }
+    ESP_ERROR_CHECK(ap_view_init(&ap_view, &damage, UI_BAND_WIDTH, 0, ap_view_width, pax_buf_get_height(&fb),
+                                 1 << CONFIG_WIFI_TEST_AP_CACHE_SIZE_LOG2, BLACK, WHITE));
 
     // Get input event queue from BSP
     ESP_ERROR_CHECK(bsp_input_get_queue(&input_event_queue));
 
     ESP_LOGW(TAG, "Hello world!");
 
-    pax_background(&fb, WHITE);
-    pax_draw_text(&fb, BLACK, pax_font_sky_mono, 16, 0, 0, "Hello world!");
+#if CONFIG_WIFI_TEST_TEXT_BENCHMARK
+    text_benchmark();
+#endif
+
+    fb_damage_rect(&damage, WHITE, 0, 0, pax_buf_get_width(&fb), pax_buf_get_height(&fb));
+    fb_damage_text(&damage, BLACK, pax_font_sky_mono, 16, 0, 0, "Hello world!");
     blit();
+    ESP_LOGI(TAG, "First frame on screen %" PRId64 " ms after boot", esp_timer_get_time() / 1000);
+
+    // From here on only render_task touches the framebuffer. Without it the input loop draws, and
+    // changes made by other tasks show up with the next input event.
+    if (memstat_task_create(render_task, "render", 4096, NULL, 3, &render_task_handle, tskNO_AFFINITY) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to start the render task, drawing from the input loop");
+    }
+    ui_model_mark(UI_DIRTY_AP_LIST);
 
     while (1) {
         bsp_input_event_t event;
-        if (xQueueReceive(input_event_queue, &event, portMAX_DELAY) == pdTRUE) {
-            switch (event.type) {
-                case INPUT_EVENT_TYPE_KEYBOARD: {
-                    if (event.args_keyboard.ascii != '\b' ||
-                        event.args_keyboard.ascii != '\t') {  // Ignore backspace & tab keyboard events
-                        ESP_LOGI(TAG, "Keyboard event %c (%02x) %s", event.args_keyboard.ascii,
-                                 (uint8_t)event.args_keyboard.ascii, event.args_keyboard.utf8);
-                        pax_simple_rect(&fb, WHITE, 0, 0, pax_buf_get_width(&fb), 72);
-                        pax_draw_text(&fb, BLACK, pax_font_sky_mono, 16, 0, 0, "Keyboard event");
-                        char text[64];
-                        snprintf(text, sizeof(text), "ASCII:     %c (0x%02x)", event.args_keyboard.ascii,
-                                 (uint8_t)event.args_keyboard.ascii);
-                        pax_draw_text(&fb, BLACK, pax_font_sky_mono, 16, 0, 18, text);
-                        snprintf(text, sizeof(text), "UTF-8:     %s", event.args_keyboard.utf8);
-                        pax_draw_text(&fb, BLACK, pax_font_sky_mono, 16, 0, 36, text);
-                        snprintf(text, sizeof(text), "Modifiers: 0x%0" PRIX32, event.args_keyboard.modifiers);
-                        pax_draw_text(&fb, BLACK, pax_font_sky_mono, 16, 0, 54, text);
-                        blit();
-                    }
-                    break;
-                }
-                case INPUT_EVENT_TYPE_NAVIGATION: {
-                    ESP_LOGI(TAG, "Navigation event %0" PRIX32 ": %s", (uint32_t)event.args_navigation.key,
-                             event.args_navigation.state ? "pressed" : "released");
-
-                    if (event.args_navigation.key == BSP_INPUT_NAVIGATION_KEY_F1) {
-                        bsp_device_restart_to_launcher();
-                    }
-                    if (event.args_navigation.key == BSP_INPUT_NAVIGATION_KEY_F2) {
-                        bsp_input_set_backlight_brightness(0);
-                    }
-                    if (event.args_navigation.key == BSP_INPUT_NAVIGATION_KEY_F3) {
-                        bsp_input_set_backlight_brightness(100);
-                    }
-
-                    pax_simple_rect(&fb, WHITE, 0, 100, pax_buf_get_width(&fb), 72);
-                    pax_draw_text(&fb, BLACK, pax_font_sky_mono, 16, 0, 100 + 0, "Navigation event");
-                    char text[64];
-                    snprintf(text, sizeof(text), "Key:       0x%0" PRIX32, (uint32_t)event.args_navigation.key);
-                    pax_draw_text(&fb, BLACK, pax_font_sky_mono, 16, 0, 100 + 18, text);
-                    snprintf(text, sizeof(text), "State:     %s", event.args_navigation.state ? "pressed" : "released");
-                    pax_draw_text(&fb, BLACK, pax_font_sky_mono, 16, 0, 100 + 36, text);
-                    snprintf(text, sizeof(text), "Modifiers: 0x%0" PRIX32, event.args_navigation.modifiers);
-                    pax_draw_text(&fb, BLACK, pax_font_sky_mono, 16, 0, 100 + 54, text);
-                    blit();
-                    break;
-                }
-                case INPUT_EVENT_TYPE_ACTION: {
-                    ESP_LOGI(TAG, "Action event 0x%0" PRIX32 ": %s", (uint32_t)event.args_action.type,
-                             event.args_action.state ? "yes" : "no");
-                    pax_simple_rect(&fb, WHITE, 0, 200 + 0, pax_buf_get_width(&fb), 72);
-                    pax_draw_text(&fb, BLACK, pax_font_sky_mono, 16, 0, 200 + 0, "Action event");
-                    char text[64];
-                    snprintf(text, sizeof(text), "Type:      0x%0" PRIX32, (uint32_t)event.args_action.type);
-                    pax_draw_text(&fb, BLACK, pax_font_sky_mono, 16, 0, 200 + 36, text);
-                    snprintf(text, sizeof(text), "State:     %s", event.args_action.state ? "yes" : "no");
-                    pax_draw_text(&fb, BLACK, pax_font_sky_mono, 16, 0, 200 + 54, text);
-                    blit();
-                    break;
-                }
-                case INPUT_EVENT_TYPE_SCANCODE: {
-                    ESP_LOGI(TAG, "Scancode event 0x%0" PRIX32, (uint32_t)event.args_scancode.scancode);
-                    pax_simple_rect(&fb, WHITE, 0, 300 + 0, pax_buf_get_width(&fb), 72);
-                    pax_draw_text(&fb, BLACK, pax_font_sky_mono, 16, 0, 300 + 0, "Scancode event");
-                    char text[64];
-                    snprintf(text, sizeof(text), "Scancode:  0x%0" PRIX32, (uint32_t)event.args_scancode.scancode);
-                    pax_draw_text(&fb, BLACK, pax_font_sky_mono, 16, 0, 300 + 36, text);
-                    blit();
-                    break;
-                }
-                default:
-                    break;
-            }
+        if (xQueueReceive(input_event_queue, &event, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        int64_t  now   = esp_timer_get_time();
+        uint32_t depth = uxQueueMessagesWaiting(input_event_queue) + 1;
+        taskENTER_CRITICAL(&ui_model_lock);
+        if (depth > ui_model.queue_depth) {
+            ui_model.queue_depth = depth;
+        }
+        taskEXIT_CRITICAL(&ui_model_lock);
+
+        // Drain the whole backlog before waking the renderer
+        do {
+            handle_input_event(&event, now);
+        } while (xQueueReceive(input_event_queue, &event, 0) == pdTRUE);
+        if (render_task_handle != NULL) {
+            xTaskNotifyGive(render_task_handle);
+        } else {
+            render_frame();
         }
     }
 }
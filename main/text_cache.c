@@ -0,0 +1,80 @@
+#include "text_cache.h"
+#include <math.h>
+#include <string.h>
+#include "pax_text.h"
+
+void text_cache_init(text_cache_t* cache, fb_damage_t* damage, pax_font_t const* font, float font_size,
+                     pax_col_t background) {
+    memset(cache, 0, sizeof(*cache));
+    cache->damage     = damage;
+    cache->font       = font;
+    cache->font_size  = font_size;
+    cache->background = background;
+}
+
+static text_cache_entry_t* text_cache_find(text_cache_t* cache, pax_col_t color, int x, int y, char const* text) {
+    for (uint8_t i = 0; i < cache->count; i++) {
+        text_cache_entry_t* entry = &cache->entries[i];
+        if (entry->x == x && entry->y == y && entry->color == color && strcmp(entry->text, text) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static pax_vec2f text_cache_render(text_cache_t* cache, pax_col_t color, int x, int y, char const* text) {
+    pax_vec2f size = pax_text_size(cache->font, cache->font_size, text);
+    fb_damage_rect(cache->damage, cache->background, x, y, (int)ceilf(size.x), (int)ceilf(size.y));
+    fb_damage_text(cache->damage, color, cache->font, cache->font_size, x, y, text);
+    return size;
+}
+
+// Copy a native rectangle between the framebuffer and a packed pixel array
+static void text_cache_copy(fb_damage_t const* damage, fb_rect_t const* native, uint8_t* pixels, bool to_fb) {
+    size_t   bpp    = damage->bytes_per_pixel;
+    size_t   stride = damage->native_width * bpp;
+    size_t   row    = native->w * bpp;
+    uint8_t* origin = (uint8_t*)pax_buf_get_pixels(damage->buf) + native->y * stride + native->x * bpp;
+    for (int line = 0; line < native->h; line++) {
+        if (to_fb) {
+            memcpy(origin + line * stride, pixels + line * row, row);
+        } else {
+            memcpy(pixels + line * row, origin + line * stride, row);
+        }
+    }
+}
+
+pax_vec2f text_cache_draw(text_cache_t* cache, pax_col_t color, int x, int y, char const* text) {
+    fb_damage_t* damage = cache->damage;
+    if (cache->bypass || damage->bytes_per_pixel == 0) {
+        return text_cache_render(cache, color, x, y, text);
+    }
+
+    text_cache_entry_t* entry = text_cache_find(cache, color, x, y, text);
+    if (entry) {
+        cache->hits++;
+        if (entry->pixels) {
+            text_cache_copy(damage, &entry->native, entry->pixels, true);
+            fb_damage_add(damage, x, y, (int)ceilf(entry->size.x), (int)ceilf(entry->size.y));
+            return entry->size;
+        }
+        return text_cache_render(cache, color, x, y, text);  // Off screen or no memory for it
+    }
+
+    cache->misses++;
+    pax_vec2f size = text_cache_render(cache, color, x, y, text);
+    if (cache->count == TEXT_CACHE_MAX) {
+        return size;
+    }
+    entry  = &cache->entries[cache->count++];
+    *entry = (text_cache_entry_t){.text = text, .x = x, .y = y, .color = color, .size = size};
+
+    fb_rect_t rect = {x, y, (int)ceilf(size.x), (int)ceilf(size.y)};
+    if (fb_damage_native_rect(damage, &rect, &entry->native)) {
+        entry->pixels = memstat_arena_alloc(damage->arena, entry->native.w * entry->native.h * damage->bytes_per_pixel);
+        if (entry->pixels) {
+            text_cache_copy(damage, &entry->native, entry->pixels, false);
+        }
+    }
+    return size;
+}
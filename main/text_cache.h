@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "fb_damage.h"
+#include "pax_gfx.h"
+
+#define TEXT_CACHE_MAX 24
+
+typedef struct {
+    char const* text;    // Not copied, labels are string literals
+    int         x;
+    int         y;
+    pax_col_t   color;
+    pax_vec2f   size;
+    fb_rect_t   native;  // Panel pixels the label covers
+    uint8_t*    pixels;  // Those pixels as rendered, native.h rows of native.w pixels
+} text_cache_entry_t;
+
+// Static labels drawn at fixed places. The first draw of a label rasterizes it over the
+// background color and keeps a copy of the resulting framebuffer pixels, in the framebuffer's
+// own format and orientation; later draws copy those pixels back row by row.
+typedef struct {
+    fb_damage_t*       damage;
+    pax_font_t const*  font;
+    float              font_size;
+    pax_col_t          background;
+    bool               bypass;  // Draw everything with PAX, for comparing
+    text_cache_entry_t entries[TEXT_CACHE_MAX];
+    uint8_t            count;
+    uint32_t           hits;
+    uint32_t           misses;
+} text_cache_t;
+
+void text_cache_init(text_cache_t* cache, fb_damage_t* damage, pax_font_t const* font, float font_size,
+                     pax_col_t background);
+
+// Draw a label with its background filled in, and record the damage. Labels the cache cannot
+// hold (sub-byte pixel formats, a full cache, out of memory) are drawn with PAX every time.
+pax_vec2f text_cache_draw(text_cache_t* cache, pax_col_t color, int x, int y, char const* text);
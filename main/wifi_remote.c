@@ -0,0 +1,100 @@
+#include "wifi_remote.h"
+#include <inttypes.h>
+#include "bsp/power.h"
+#include "esp_hosted_custom.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "host/port/sdio_wrapper.h"
+#include "trace.h"
+
+// The radio needs to be held off briefly to reset, this is not a readiness wait
+#define RADIO_RESET_HOLD_MS 50
+
+// Readiness is polled with exponential backoff instead of a fixed boot delay
+#define RADIO_POLL_FIRST_MS 10
+#define RADIO_POLL_MAX_MS   160
+#define RADIO_READY_TIMEOUT 3000
+
+static char const TAG[] = "wifi_remote";
+
+static bool    initialized = false;
+static bool    powered     = false;
+static int64_t powered_at  = 0;
+
+bool wifi_remote_get_initialized(void) {
+    return initialized;
+}
+
+void wifi_remote_power_on(void) {
+    ESP_LOGW(TAG, "Switching radio off...");
+    bsp_power_set_radio_state(BSP_POWER_RADIO_STATE_OFF);
+    vTaskDelay(pdMS_TO_TICKS(RADIO_RESET_HOLD_MS));
+    ESP_LOGW(TAG, "Switching radio to application mode...");
+    bsp_power_set_radio_state(BSP_POWER_RADIO_STATE_APPLICATION);
+    powered_at = esp_timer_get_time();
+    powered    = true;
+}
+
+static esp_err_t wifi_remote_wait_radio_ready(void) {
+    trace_span_t span = trace_begin("hosted_sdio_init");
+    void*        card = hosted_sdio_init();
+    trace_end(&span);
+    if (card == NULL) {
+        ESP_LOGE(TAG, "Failed to initialize SDIO for radio");
+        return ESP_FAIL;
+    }
+
+    uint32_t  delay_ms = RADIO_POLL_FIRST_MS;
+    uint32_t  polls    = 0;
+    esp_err_t res      = ESP_FAIL;
+    span               = trace_begin("radio_ready_poll");
+    while (1) {
+        polls++;
+        res = hosted_sdio_card_init(NULL);
+        if (res == ESP_OK) {
+            break;
+        }
+        int64_t elapsed_ms = (esp_timer_get_time() - powered_at) / 1000;
+        if (elapsed_ms + delay_ms > RADIO_READY_TIMEOUT) {
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(delay_ms));
+        if (delay_ms < RADIO_POLL_MAX_MS) {
+            delay_ms *= 2;
+        }
+    }
+
+    trace_end(&span);
+
+    int64_t elapsed_ms = (esp_timer_get_time() - powered_at) / 1000;
+    if (res == ESP_OK) {
+        ESP_LOGI(TAG, "Radio ready %" PRId64 " ms after power on (%" PRIu32 " polls)", elapsed_ms, polls);
+    } else {
+        ESP_LOGE(TAG, "Radio not ready after %" PRId64 " ms (%" PRIu32 " polls)", elapsed_ms, polls);
+    }
+    return res;
+}
+
+esp_err_t wifi_remote_initialize(void) {
+    if (initialized) {
+        return ESP_OK;
+    }
+    if (!powered) {
+        wifi_remote_power_on();
+    }
+    trace_span_t span = trace_begin("wifi_remote_initialize");
+    ESP_LOGW(TAG, "Testing connection to radio...");
+    if (wifi_remote_wait_radio_ready() != ESP_OK) {
+        trace_end(&span);
+        return ESP_ERR_INVALID_STATE;
+    }
+    ESP_LOGW(TAG, "Starting ESP hosted...");
+    trace_span_t host_span = trace_begin("esp_hosted_host_init");
+    esp_hosted_host_init();
+    trace_end(&host_span);
+    trace_end(&span);
+    initialized = true;
+    return ESP_OK;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <stdbool.h>
+#include "esp_err.h"
+
+// Reset the radio co-processor and switch it to application mode. Returns right away,
+// the radio boots in the background.
+void wifi_remote_power_on(void);
+
+// Wait for the radio to answer on SDIO and start ESP hosted. Calls wifi_remote_power_on()
+// first when that has not been done yet.
+esp_err_t wifi_remote_initialize(void);
+
+bool wifi_remote_get_initialized(void);
@@ -0,0 +1,609 @@
+#include "wifi_scan.h"
+#include <inttypes.h>
+#include <string.h>
+#include "esp_check.h"
+#include "esp_event.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "freertos/event_groups.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "ap_cache.h"
+#include "ap_history.h"
+#include "ap_rank.h"
+#include "ap_topk.h"
+#include "memstat.h"
+#include "scan_capture.h"
+#include "scan_scheduler.h"
+#include "sdkconfig.h"
+#include "trace.h"
+#include "wifi_rpc.h"
+#include "wifi_scan_session.h"
+#if defined(CONFIG_WIFI_TEST_SCAN_CAPTURE)
+#include "esp_vfs_fat.h"
+#endif
+#if defined(CONFIG_WIFI_TEST_SCAN_CAPTURE_SDMMC)
+#include "driver/sdmmc_host.h"
+#if CONFIG_WIFI_TEST_SCAN_CAPTURE_SD_LDO >= 0
+#include "sd_pwr_ctrl_by_on_chip_ldo.h"
+#endif
+#endif
+
+#define SCAN_RESULT_QUEUE_LENGTH 2
+#define SCAN_TASK_STACK_SIZE     4096
+#define SCAN_TASK_PRIORITY       5
+#define SCAN_TIMEOUT_MS          15000
+#define SCAN_POOL_SLOTS          (SCAN_RESULT_QUEUE_LENGTH + 2)
+#define SCAN_CACHE_SIZE          (1 << CONFIG_WIFI_TEST_AP_CACHE_SIZE_LOG2)
+#define SCAN_CACHE_EWMA_SHIFT    2
+#define SCAN_HISTORY_SIZE        (1 << CONFIG_WIFI_TEST_AP_HISTORY_SIZE_LOG2)
+#define SCAN_RETRY_MS            1000  // Background idle time after a failed sweep, doubling per failure
+#define SCAN_RETRY_MAX_SHIFT     6
+#define SCAN_ARENA_SIZE          (CONFIG_WIFI_TEST_SCAN_ARENA_KB * 1024)
+
+#define SCAN_BIT_REQUEST   BIT0
+#define SCAN_BIT_DONE      BIT1
+#define SCAN_BIT_BUSY      BIT2
+#define SCAN_BIT_BENCHMARK BIT3
+#define SCAN_BIT_READY     BIT4
+#define SCAN_BIT_WAKE      BIT5  // Background mode changed
+#define SCAN_BIT_SWEPT     BIT6  // A sweep finished, successful or not
+
+#if defined(CONFIG_WIFI_TEST_SCAN_ADAPTIVE)
+#define SCAN_ADAPTIVE true
+#else
+#define SCAN_ADAPTIVE false
+#endif
+
+#if defined(CONFIG_WIFI_TEST_SCAN_BACKGROUND)
+#define SCAN_BACKGROUND true
+#else
+#define SCAN_BACKGROUND false
+#endif
+
+// State of one sweep, which may consist of several scans over different channel sets
+typedef struct {
+    ap_topk_t topk;
+    int64_t   now;
+    uint16_t  total;
+    uint16_t  channel_counts[SCAN_SCHEDULER_CHANNELS + 1];
+    bool      merge;     // Records go into the AP table and RSSI history, benchmark sweeps stay out
+    bool      recorded;  // Records went into the RSSI history, which counts this sweep as a scan
+} scan_sweep_t;
+
+static char const TAG[] = "wifi_scan";
+
+static TaskHandle_t        scan_task    = NULL;
+static QueueHandle_t       result_queue = NULL;
+static EventGroupHandle_t  scan_events  = NULL;
+static volatile uint32_t   done_status  = 0;
+static uint32_t            sequence     = 0;
+static wifi_scan_session_t session      = {0};
+static wifi_ap_record_t*   pool_records = NULL;  // SCAN_POOL_SLOTS buffers of CONFIG_WIFI_TEST_SCAN_TOP_K records
+static wifi_ap_record_t*   fetched      = NULL;  // CONFIG_WIFI_TEST_SCAN_FETCH_MAX records
+static uint32_t            pool_used    = 0;
+static memstat_arena_t     arena        = {0};  // Record pool, fetch buffer, AP table and RSSI history
+static portMUX_TYPE        pool_lock    = portMUX_INITIALIZER_UNLOCKED;
+static ap_cache_t          cache        = {0};
+static SemaphoreHandle_t   cache_lock   = NULL;
+static SemaphoreHandle_t   radio_lock   = NULL;
+static scan_scheduler_t    scheduler    = {0};
+static ap_history_t        history      = {0};
+static ap_rank_t           rank         = {0};
+static volatile bool       background   = SCAN_BACKGROUND;
+static int64_t             sweep_us     = 0;  // Duration of the last sweep
+static uint8_t             failures     = 0;  // Failed sweeps in a row
+
+#if defined(CONFIG_WIFI_TEST_SCAN_CAPTURE)
+static scan_capture_writer_t capture       = {0};
+static uint32_t              capture_scans = 0;
+#endif
+
+static void scan_done_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data) {
+    wifi_event_sta_scan_done_t const* done = event_data;
+    done_status                            = done->status;
+    xEventGroupSetBits(scan_events, SCAN_BIT_DONE);
+}
+
+static wifi_ap_record_t* pool_acquire(void) {
+    wifi_ap_record_t* records = NULL;
+    taskENTER_CRITICAL(&pool_lock);
+    for (uint32_t slot = 0; slot < SCAN_POOL_SLOTS; slot++) {
+        if (!(pool_used & (1 << slot))) {
+            pool_used |= 1 << slot;
+            records = &pool_records[slot * CONFIG_WIFI_TEST_SCAN_TOP_K];
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&pool_lock);
+    return records;
+}
+
+static void pool_release(wifi_ap_record_t* records) {
+    if (records == NULL) {
+        return;
+    }
+    uint32_t slot = (records - pool_records) / CONFIG_WIFI_TEST_SCAN_TOP_K;
+    taskENTER_CRITICAL(&pool_lock);
+    pool_used &= ~(1 << slot);
+    taskEXIT_CRITICAL(&pool_lock);
+}
+
+static ap_compare_fn scan_sort_key(void) {
+#if defined(CONFIG_WIFI_TEST_SCAN_SORT_SSID)
+    return ap_compare_ssid;
+#elif defined(CONFIG_WIFI_TEST_SCAN_SORT_CHANNEL)
+    return ap_compare_channel;
+#else
+    return ap_compare_rssi;
+#endif
+}
+
+static void scan_merge_chunk(scan_sweep_t* sweep, wifi_ap_record_t const* chunk, uint16_t count, int64_t fetched_us) {
+#if defined(CONFIG_WIFI_TEST_SCAN_CAPTURE)
+    if (capture.file && scan_capture_write(&capture, capture_scans, fetched_us, chunk, count) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to write capture, capturing stopped");
+        scan_capture_close(&capture);
+    }
+#endif
+    if (sweep->merge) {
+        xSemaphoreTake(cache_lock, portMAX_DELAY);
+        if (!sweep->recorded && count > 0) {
+            // Sweeps without records do not count as a scan, or a failing radio would age out every AP
+            ap_history_begin_scan(&history);
+            sweep->recorded = true;
+        }
+        for (uint16_t i = 0; i < count; i++) {
+            ap_cache_update(&cache, &chunk[i], sweep->now);
+            ap_history_record(&history, &chunk[i]);
+        }
+        xSemaphoreGive(cache_lock);
+    }
+    for (uint16_t i = 0; i < count; i++) {
+        ap_topk_offer(&sweep->topk, &chunk[i]);
+        if (chunk[i].primary <= SCAN_SCHEDULER_CHANNELS) {
+            sweep->channel_counts[chunk[i].primary]++;
+        }
+    }
+}
+
+static esp_err_t scan_fetch_records(scan_sweep_t* sweep) {
+    uint16_t total = 0;
+    ESP_RETURN_ON_ERROR(wifi_scan_session_ap_count(&session, &total), TAG, "Failed to get number of APs");
+    sweep->total += total;
+    int64_t fetched_us = esp_timer_get_time();
+
+    // The radio frees its list on the first bulk read, so everything is fetched with one RPC and
+    // split into chunks here
+    uint16_t  count = total < CONFIG_WIFI_TEST_SCAN_FETCH_MAX ? total : CONFIG_WIFI_TEST_SCAN_FETCH_MAX;
+    esp_err_t res   = wifi_scan_session_fetch(&session, fetched, &count);
+    for (uint16_t offset = 0; offset < count; offset += CONFIG_WIFI_TEST_SCAN_FETCH_CHUNK) {
+        uint16_t length = count - offset;
+        if (length > CONFIG_WIFI_TEST_SCAN_FETCH_CHUNK) {
+            length = CONFIG_WIFI_TEST_SCAN_FETCH_CHUNK;
+        }
+        scan_merge_chunk(sweep, &fetched[offset], length, fetched_us);
+    }
+
+#if defined(CONFIG_WIFI_TEST_SCAN_CAPTURE)
+    if (capture.file) {
+        fflush(capture.file);  // Keep whole scans on disk in case power goes away
+        capture_scans++;
+    }
+#endif
+
+    if (res != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to fetch AP records");
+    }
+    return res;
+}
+
+static esp_err_t scan_step(scan_sweep_t* sweep, wifi_scan_config_t const* cfg) {
+    memset(sweep->channel_counts, 0, sizeof(sweep->channel_counts));
+    xEventGroupClearBits(scan_events, SCAN_BIT_DONE);
+
+    // Covers scan start until the done event, the fetch RPCs are traced separately
+    trace_span_t span = trace_begin("scan");
+    esp_err_t    res  = wifi_scan_session_start(&session, cfg);
+    if (res != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start scan");
+        trace_end(&span);
+        return res;
+    }
+
+    EventBits_t bits = xEventGroupWaitBits(scan_events, SCAN_BIT_DONE, pdTRUE, pdFALSE, pdMS_TO_TICKS(SCAN_TIMEOUT_MS));
+    trace_end(&span);
+    if (!(bits & SCAN_BIT_DONE)) {
+        ESP_LOGE(TAG, "Scan timed out");
+        TRACE_CALL("esp_wifi_scan_stop", wifi_rpc_scan_stop());
+        return ESP_ERR_TIMEOUT;
+    }
+    if (done_status != 0) {
+        ESP_LOGE(TAG, "Scan failed with status %" PRIu32, done_status);
+        return ESP_FAIL;
+    }
+    return scan_fetch_records(sweep);
+}
+
+static esp_err_t scan_sweep(scan_sweep_t* sweep, bool adaptive) {
+    sweep->now      = esp_timer_get_time();
+    sweep->total    = 0;
+    sweep->recorded = false;
+
+    if (!adaptive) {
+        wifi_scan_config_t cfg = {
+            .ssid      = NULL,
+            .bssid     = NULL,
+            .channel   = 0,
+            .scan_type = WIFI_SCAN_TYPE_ACTIVE,
+            .scan_time = {.active = {0, 0}},
+        };
+        esp_err_t res = scan_step(sweep, &cfg);
+        if (res == ESP_OK) {
+            scan_scheduler_observe(&scheduler, scheduler.allowed, sweep->channel_counts);
+        }
+        return res;
+    }
+
+    scan_plan_t plan;
+    scan_scheduler_plan(&scheduler, &plan);
+    for (uint8_t i = 0; i < plan.count; i++) {
+        wifi_scan_config_t cfg;
+        scan_scheduler_config(&plan.steps[i], &cfg);
+        ESP_RETURN_ON_ERROR(scan_step(sweep, &cfg), TAG, "Sweep step %u failed", i);
+        scan_scheduler_observe(&scheduler, plan.steps[i].channels, sweep->channel_counts);
+    }
+    return ESP_OK;
+}
+
+static void scan_publish(wifi_scan_result_t* result) {
+    if (xQueueSend(result_queue, result, 0) == pdTRUE) {
+        return;
+    }
+    // Consumers are lagging behind, drop the oldest result in favour of the newest one
+    wifi_scan_result_t stale;
+    if (xQueueReceive(result_queue, &stale, 0) == pdTRUE) {
+        wifi_scan_result_release(&stale);
+    }
+    if (xQueueSend(result_queue, result, 0) != pdTRUE) {
+        wifi_scan_result_release(result);
+    }
+}
+
+static void scan_run(void) {
+    wifi_scan_result_t result = {.sequence = ++sequence};
+    scan_sweep_t       sweep;
+
+    // Without a free result buffer the sweep still updates the AP table
+    wifi_ap_record_t* storage = pool_acquire();
+    if (storage == NULL) {
+        ESP_LOGW(TAG, "All result buffers are in use, only updating the AP table");
+    }
+    ap_topk_init(&sweep.topk, storage, storage ? CONFIG_WIFI_TEST_SCAN_TOP_K : 0, scan_sort_key());
+    sweep.merge = true;
+
+    xSemaphoreTake(radio_lock, portMAX_DELAY);
+    xEventGroupSetBits(scan_events, SCAN_BIT_BUSY);
+    int64_t start      = esp_timer_get_time();
+    result.status      = scan_sweep(&sweep, SCAN_ADAPTIVE);
+    result.duration_us = esp_timer_get_time() - start;
+    result.total       = sweep.total;
+    xEventGroupClearBits(scan_events, SCAN_BIT_BUSY);
+    xSemaphoreGive(radio_lock);
+
+    sweep_us = result.duration_us;
+    if (result.status == ESP_OK) {
+        failures = 0;
+    } else if (failures < UINT8_MAX) {
+        failures++;
+    }
+
+    xSemaphoreTake(cache_lock, portMAX_DELAY);
+    ap_cache_evict(&cache, sweep.now, (int64_t)CONFIG_WIFI_TEST_AP_CACHE_MAX_AGE * 1000000);
+    if (sweep.recorded) {
+        ap_history_end_scan(&history);
+    }
+    ap_rank_update(&rank, &cache);
+    xSemaphoreGive(cache_lock);
+    xEventGroupSetBits(scan_events, SCAN_BIT_SWEPT);
+
+    if (storage == NULL && result.status == ESP_OK) {
+        result.status = ESP_ERR_NO_MEM;
+    }
+    if (result.status != ESP_OK) {
+        pool_release(storage);
+    } else {
+        ap_topk_sort(&sweep.topk);
+        result.records = storage;
+        result.count   = sweep.topk.count;
+    }
+
+    wifi_scan_session_log_stats(&session);
+    scan_publish(&result);
+}
+
+static void scan_benchmark(void) {
+    static char const* const names[] = {"full", "adaptive"};
+    scan_sweep_t             sweep;
+    ap_topk_init(&sweep.topk, NULL, 0, scan_sort_key());
+    sweep.merge = false;  // Sweeps at benchmark pace would skew the RSSI history and AP ages
+
+    xSemaphoreTake(radio_lock, portMAX_DELAY);
+    xEventGroupSetBits(scan_events, SCAN_BIT_BUSY);
+    int64_t  elapsed[2] = {0};
+    uint32_t found[2]   = {0};
+    uint32_t rounds[2]  = {0};
+    // Full and adaptive sweeps alternate, so drift in the radio environment affects both alike
+    for (uint32_t round = 0; round < CONFIG_WIFI_TEST_SCAN_BENCHMARK_ROUNDS; round++) {
+        for (int adaptive = 0; adaptive < 2; adaptive++) {
+            int64_t start = esp_timer_get_time();
+            if (scan_sweep(&sweep, adaptive) != ESP_OK) {
+                continue;
+            }
+            elapsed[adaptive] += esp_timer_get_time() - start;
+            found[adaptive]   += sweep.total;
+            rounds[adaptive]++;
+        }
+    }
+    for (int adaptive = 0; adaptive < 2; adaptive++) {
+        if (rounds[adaptive] == 0 || elapsed[adaptive] == 0) {
+            ESP_LOGE(TAG, "Benchmark (%s): no successful sweeps", names[adaptive]);
+            continue;
+        }
+        ESP_LOGI(TAG, "Benchmark (%s): %" PRIu32 " sweeps, %" PRId64 " ms/sweep, %" PRIu32 " APs/sweep, %" PRId64
+                 " APs/s", names[adaptive], rounds[adaptive], elapsed[adaptive] / rounds[adaptive] / 1000,
+                 found[adaptive] / rounds[adaptive], (int64_t)found[adaptive] * 1000000 / elapsed[adaptive]);
+    }
+    wifi_scan_session_log_rpc_stats();
+    xEventGroupClearBits(scan_events, SCAN_BIT_BUSY);
+    xSemaphoreGive(radio_lock);
+}
+
+// Time to leave the radio alone after a sweep, so background sweeps keep to their duty cycle
+static TickType_t scan_idle_ticks(void) {
+    if (!background) {
+        return portMAX_DELAY;
+    }
+    if (failures > 0) {
+        // A failed sweep takes a few ms, the duty cycle alone would retry in a tight loop
+        uint8_t shift = failures - 1 < SCAN_RETRY_MAX_SHIFT ? failures - 1 : SCAN_RETRY_MAX_SHIFT;
+        return pdMS_TO_TICKS(SCAN_RETRY_MS << shift);
+    }
+    int64_t idle_us = sweep_us * (100 - CONFIG_WIFI_TEST_SCAN_BACKGROUND_DUTY) / CONFIG_WIFI_TEST_SCAN_BACKGROUND_DUTY;
+    return (idle_us * configTICK_RATE_HZ + 999999) / 1000000;
+}
+
+#if defined(CONFIG_WIFI_TEST_SCAN_CAPTURE_SDMMC)
+// The SDMMC host may already be up for the SDIO link to the radio, it is shared and never shut down
+static esp_err_t scan_sd_host_init(void) {
+    esp_err_t res = sdmmc_host_init();
+    return res == ESP_ERR_INVALID_STATE ? ESP_OK : res;
+}
+
+static esp_err_t scan_sd_host_deinit(void) {
+    return ESP_OK;
+}
+#endif
+
+#if defined(CONFIG_WIFI_TEST_SCAN_CAPTURE)
+// Mount the filesystem the capture is written to, stays mounted for the lifetime of the task
+static esp_err_t scan_capture_mount(void) {
+    esp_vfs_fat_mount_config_t mount = {
+        .format_if_mount_failed = false,
+        .max_files              = 2,
+        .allocation_unit_size   = 16 * 1024,
+    };
+#if defined(CONFIG_WIFI_TEST_SCAN_CAPTURE_SDMMC)
+    sdmmc_host_t        host = SDMMC_HOST_DEFAULT();
+    sdmmc_slot_config_t slot = SDMMC_SLOT_CONFIG_DEFAULT();
+    host.slot                = CONFIG_WIFI_TEST_SCAN_CAPTURE_SD_SLOT;
+    host.init                = scan_sd_host_init;
+    host.deinit              = scan_sd_host_deinit;
+#if CONFIG_WIFI_TEST_SCAN_CAPTURE_SD_LDO >= 0
+    sd_pwr_ctrl_ldo_config_t ldo   = {.ldo_chan_id = CONFIG_WIFI_TEST_SCAN_CAPTURE_SD_LDO};
+    sd_pwr_ctrl_handle_t     power = NULL;
+    ESP_RETURN_ON_ERROR(sd_pwr_ctrl_new_on_chip_ldo(&ldo, &power), TAG, "Failed to power the SD card");
+    host.pwr_ctrl_handle = power;
+#endif
+    sdmmc_card_t* card = NULL;
+    esp_err_t     res  = esp_vfs_fat_sdmmc_mount(CONFIG_WIFI_TEST_SCAN_CAPTURE_MOUNT, &host, &slot, &mount, &card);
+#if CONFIG_WIFI_TEST_SCAN_CAPTURE_SD_LDO >= 0
+    if (res != ESP_OK) {
+        sd_pwr_ctrl_del_on_chip_ldo(power);  // Switch the card off again
+    }
+#endif
+    return res;
+#elif defined(CONFIG_WIFI_TEST_SCAN_CAPTURE_FLASH)
+    wl_handle_t wl = WL_INVALID_HANDLE;
+    return esp_vfs_fat_spiflash_mount_rw_wl(CONFIG_WIFI_TEST_SCAN_CAPTURE_MOUNT,
+                                            CONFIG_WIFI_TEST_SCAN_CAPTURE_PARTITION, &mount, &wl);
+#else
+    return ESP_OK;  // Mounted by whoever configured the path
+#endif
+}
+#endif
+
+static void scan_task_main(void* arg) {
+    esp_err_t res = wifi_scan_session_open(&session, scan_done_handler, NULL);
+    if (res != ESP_OK) {
+        ESP_LOGE(TAG, "WiFi stack initialization failed: %s", esp_err_to_name(res));
+        wifi_scan_result_t result = {.status = res};
+        scan_publish(&result);
+        scan_task = NULL;
+        memstat_task_exit();
+        return;
+    }
+    scan_scheduler_init(&scheduler, CONFIG_WIFI_TEST_SCAN_CHANNELS);
+#if defined(CONFIG_WIFI_TEST_SCAN_CAPTURE)
+    res = scan_capture_mount();
+    if (res != ESP_OK) {
+        ESP_LOGW(TAG, "Cannot mount the capture filesystem: %s", esp_err_to_name(res));
+    } else if (scan_capture_open(&capture, CONFIG_WIFI_TEST_SCAN_CAPTURE_PATH) == ESP_OK) {
+        ESP_LOGI(TAG, "Capturing scans to %s", CONFIG_WIFI_TEST_SCAN_CAPTURE_PATH);
+    } else {
+        ESP_LOGW(TAG, "Cannot create %s, not capturing scans", CONFIG_WIFI_TEST_SCAN_CAPTURE_PATH);
+    }
+#endif
+    xEventGroupSetBits(scan_events, SCAN_BIT_READY);
+    EventBits_t const wait_bits = SCAN_BIT_REQUEST | SCAN_BIT_BENCHMARK | SCAN_BIT_WAKE;
+    while (1) {
+        EventBits_t bits = xEventGroupWaitBits(scan_events, wait_bits, pdTRUE, pdFALSE, scan_idle_ticks()) & wait_bits;
+        if (bits & SCAN_BIT_BENCHMARK) {
+            scan_benchmark();
+        }
+        // A background sweep is due when the idle time ran out without anything else happening
+        if ((bits & SCAN_BIT_REQUEST) || (background && bits == 0)) {
+            scan_run();
+        }
+    }
+}
+
+esp_err_t wifi_scan_engine_start(QueueHandle_t* out_result_queue) {
+    if (scan_task != NULL) {
+        if (out_result_queue) {
+            *out_result_queue = result_queue;
+        }
+        return ESP_OK;
+    }
+
+    if (scan_events == NULL) {
+        scan_events = xEventGroupCreate();
+    }
+    if (result_queue == NULL) {
+        result_queue = xQueueCreate(SCAN_RESULT_QUEUE_LENGTH, sizeof(wifi_scan_result_t));
+    }
+    if (arena.name == NULL) {
+        memstat_arena_init(&arena, "scan", SCAN_ARENA_SIZE, MALLOC_CAP_DEFAULT);
+    }
+    if (pool_records == NULL) {
+        // All record storage is taken from the arena up front, scans never allocate
+        pool_records =
+            memstat_arena_alloc(&arena, SCAN_POOL_SLOTS * CONFIG_WIFI_TEST_SCAN_TOP_K * sizeof(wifi_ap_record_t));
+        fetched = memstat_arena_alloc(&arena, CONFIG_WIFI_TEST_SCAN_FETCH_MAX * sizeof(wifi_ap_record_t));
+    }
+    if (cache.entries == NULL) {
+        ap_cache_entry_t* entries = memstat_arena_alloc(&arena, SCAN_CACHE_SIZE * sizeof(ap_cache_entry_t));
+        if (entries) {
+            ap_cache_init(&cache, entries, SCAN_CACHE_SIZE, SCAN_CACHE_EWMA_SHIFT);
+        }
+    }
+    if (history.slots == NULL) {
+        ap_history_slot_t* slots = memstat_arena_alloc(&arena, SCAN_HISTORY_SIZE * sizeof(ap_history_slot_t));
+        if (slots) {
+            ap_history_init(&history, slots, SCAN_HISTORY_SIZE);
+        }
+    }
+    if (cache_lock == NULL) {
+        cache_lock = xSemaphoreCreateMutex();
+    }
+    if (radio_lock == NULL) {
+        radio_lock = xSemaphoreCreateMutex();
+    }
+    if (scan_events == NULL || result_queue == NULL || pool_records == NULL || fetched == NULL ||
+        cache.entries == NULL || history.slots == NULL || cache_lock == NULL || radio_lock == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (memstat_task_create(scan_task_main, "wifi_scan", SCAN_TASK_STACK_SIZE, NULL, SCAN_TASK_PRIORITY, &scan_task,
+                            tskNO_AFFINITY) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (out_result_queue) {
+        *out_result_queue = result_queue;
+    }
+    return ESP_OK;
+}
+
+esp_err_t wifi_scan_request(void) {
+    if (scan_task == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xEventGroupSetBits(scan_events, SCAN_BIT_REQUEST);
+    return ESP_OK;
+}
+
+esp_err_t wifi_scan_request_wait(TickType_t timeout) {
+    if (scan_task == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xEventGroupClearBits(scan_events, SCAN_BIT_SWEPT);
+    xEventGroupSetBits(scan_events, SCAN_BIT_REQUEST);
+    EventBits_t bits = xEventGroupWaitBits(scan_events, SCAN_BIT_SWEPT, pdFALSE, pdFALSE, timeout);
+    return (bits & SCAN_BIT_SWEPT) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+esp_err_t wifi_scan_request_benchmark(void) {
+    if (scan_task == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xEventGroupSetBits(scan_events, SCAN_BIT_BENCHMARK);
+    return ESP_OK;
+}
+
+esp_err_t wifi_scan_wait_ready(TickType_t timeout) {
+    if (scan_events == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    EventBits_t bits = xEventGroupWaitBits(scan_events, SCAN_BIT_READY, pdFALSE, pdFALSE, timeout);
+    return (bits & SCAN_BIT_READY) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+esp_err_t wifi_scan_radio_acquire(TickType_t timeout) {
+    if (radio_lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return xSemaphoreTake(radio_lock, timeout) == pdTRUE ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+void wifi_scan_radio_release(void) {
+    xSemaphoreGive(radio_lock);
+}
+
+esp_err_t wifi_scan_set_background(bool enable) {
+    if (scan_task == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    background = enable;
+    xEventGroupSetBits(scan_events, enable ? SCAN_BIT_REQUEST : SCAN_BIT_WAKE);
+    return ESP_OK;
+}
+
+bool wifi_scan_background_enabled(void) {
+    return background;
+}
+
+bool wifi_scan_in_progress(void) {
+    if (scan_events == NULL) {
+        return false;
+    }
+    return (xEventGroupGetBits(scan_events) & SCAN_BIT_BUSY) != 0;
+}
+
+void wifi_scan_result_release(wifi_scan_result_t* result) {
+    pool_release(result->records);
+    result->records = NULL;
+    result->count   = 0;
+}
+
+ap_cache_t* wifi_scan_cache_acquire(void) {
+    if (cache_lock == NULL) {
+        return NULL;
+    }
+    xSemaphoreTake(cache_lock, portMAX_DELAY);
+    return &cache;
+}
+
+void wifi_scan_cache_release(void) {
+    xSemaphoreGive(cache_lock);
+}
+
+ap_history_t* wifi_scan_history(void) {
+    return &history;
+}
+
+ap_rank_t* wifi_scan_rank(void) {
+    return &rank;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ap_cache.h"
+#include "ap_history.h"
+#include "ap_rank.h"
+#include "esp_err.h"
+#include "esp_wifi_types.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+// Result of a single scan, delivered through the queue returned by wifi_scan_engine_start()
+typedef struct {
+    uint32_t          sequence;     // Incremented for every completed scan
+    esp_err_t         status;       // ESP_OK, or the reason the scan failed
+    int64_t           duration_us;  // Time between starting the scan and WIFI_EVENT_SCAN_DONE
+    uint16_t          total;        // Number of APs reported by the radio
+    uint16_t          count;        // Number of entries in records, at most CONFIG_WIFI_TEST_SCAN_TOP_K
+    wifi_ap_record_t* records;      // Best records first, return to the pool with wifi_scan_result_release()
+} wifi_scan_result_t;
+
+// Start the scan task. Results of every scan are posted to the returned queue.
+esp_err_t wifi_scan_engine_start(QueueHandle_t* out_result_queue);
+
+// Ask the scan task to run a scan. Returns immediately, requests made while a scan
+// is already running are merged into a single follow-up scan.
+esp_err_t wifi_scan_request(void);
+
+// Request a scan and wait until one has finished. Must not be called with the radio held.
+esp_err_t wifi_scan_request_wait(TickType_t timeout);
+
+// Compare the default full scan against the adaptive channel schedule over
+// CONFIG_WIFI_TEST_SCAN_BENCHMARK_ROUNDS sweeps each and log sweep time and AP discovery rate
+esp_err_t wifi_scan_request_benchmark(void);
+
+// Wait until the scan task has brought up the WiFi station
+esp_err_t wifi_scan_wait_ready(TickType_t timeout);
+
+// Keep the scan task off the radio, for example while connecting. Scans requested in
+// the meantime run after the radio is released.
+esp_err_t wifi_scan_radio_acquire(TickType_t timeout);
+void      wifi_scan_radio_release(void);
+
+bool wifi_scan_in_progress(void);
+
+// Keep sweeping in the background, spending CONFIG_WIFI_TEST_SCAN_BACKGROUND_DUTY percent of the
+// time scanning. Enabling it starts a sweep right away.
+esp_err_t wifi_scan_set_background(bool enable);
+bool      wifi_scan_background_enabled(void);
+
+void wifi_scan_result_release(wifi_scan_result_t* result);
+
+// Every record of every scan is merged into a table keyed by BSSID. Hold the table
+// with wifi_scan_cache_acquire() while reading it and hand it back when done.
+ap_cache_t* wifi_scan_cache_acquire(void);
+void        wifi_scan_cache_release(void);
+
+// The RSSI history of every scan, guarded by the same lock as the table: only read it
+// between wifi_scan_cache_acquire() and wifi_scan_cache_release().
+ap_history_t* wifi_scan_history(void);
+
+// Connection candidates ranked after every scan, guarded by the table lock as well
+ap_rank_t* wifi_scan_rank(void);
@@ -0,0 +1,131 @@
+#include "wifi_scan_session.h"
+#include <inttypes.h>
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_netif.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "trace.h"
+#include "wifi_rpc.h"
+
+// Per-call RPC latencies are logged every this many scans
+#define RPC_STATS_INTERVAL 16
+
+static char const TAG[] = "wifi_scan_session";
+
+static esp_err_t session_stack_init(void) {
+    wifi_mode_t mode;
+    if (TRACE_CALL("esp_wifi_get_mode", esp_wifi_get_mode(&mode)) == ESP_OK) {
+        // Another component already brought the WiFi stack up, reuse it
+        return ESP_OK;
+    }
+
+    ESP_RETURN_ON_ERROR(esp_netif_init(), TAG, "Failed to initialize netif");
+    esp_err_t res = esp_event_loop_create_default();
+    if (res != ESP_OK && res != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "Failed to create default event loop");
+        return res;
+    }
+    if (esp_netif_create_default_wifi_sta() == NULL) {
+        ESP_LOGE(TAG, "Failed to create station interface");
+        return ESP_FAIL;
+    }
+
+    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
+    ESP_RETURN_ON_ERROR(TRACE_CALL("esp_wifi_init", wifi_rpc_init(&cfg)), TAG, "Failed to initialize WiFi");
+    return ESP_OK;
+}
+
+esp_err_t wifi_scan_session_open(wifi_scan_session_t* session, esp_event_handler_t done_handler, void* arg) {
+    ESP_RETURN_ON_FALSE(session, ESP_ERR_INVALID_ARG, TAG, "No session");
+    if (session->initialized) {
+        return ESP_OK;
+    }
+
+    int64_t start = esp_timer_get_time();
+    ESP_RETURN_ON_ERROR(session_stack_init(), TAG, "Failed to initialize WiFi stack");
+    if (done_handler) {
+        ESP_RETURN_ON_ERROR(esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_SCAN_DONE, done_handler, arg), TAG,
+                            "Failed to register scan done handler");
+    }
+
+    int64_t cycle_start = esp_timer_get_time();
+    ESP_RETURN_ON_ERROR(TRACE_CALL("esp_wifi_set_mode", wifi_rpc_set_mode(WIFI_MODE_STA)), TAG,
+                        "Failed to set WiFi mode");
+    ESP_RETURN_ON_ERROR(TRACE_CALL("esp_wifi_start", wifi_rpc_start()), TAG, "Failed to start WiFi");
+    int64_t end = esp_timer_get_time();
+
+    session->mode_cycle_us = end - cycle_start;
+    session->setup_us      = end - start;
+    session->initialized   = true;
+    ESP_LOGI(TAG, "Session open after %" PRId64 " us (mode switch and start %" PRId64 " us)", session->setup_us,
+             session->mode_cycle_us);
+    return ESP_OK;
+}
+
+esp_err_t wifi_scan_session_start(wifi_scan_session_t* session, wifi_scan_config_t const* config) {
+    ESP_RETURN_ON_FALSE(session && session->initialized, ESP_ERR_INVALID_STATE, TAG, "Session not open");
+    int64_t   start = esp_timer_get_time();
+    esp_err_t res   = TRACE_CALL("esp_wifi_scan_start", wifi_rpc_scan_start(config, false));
+    session->last_start_us = esp_timer_get_time() - start;
+    session->total_overhead_us += session->last_start_us;
+    if (res == ESP_OK) {
+        session->scans++;
+    }
+    return res;
+}
+
+esp_err_t wifi_scan_session_ap_count(wifi_scan_session_t* session, uint16_t* out_total) {
+    ESP_RETURN_ON_FALSE(session && session->initialized, ESP_ERR_INVALID_STATE, TAG, "Session not open");
+    int64_t   start = esp_timer_get_time();
+    esp_err_t res   = TRACE_CALL("esp_wifi_scan_get_ap_num", wifi_rpc_scan_get_ap_num(out_total));
+    session->last_fetch_us = esp_timer_get_time() - start;
+    session->total_overhead_us += session->last_fetch_us;
+    return res;
+}
+
+esp_err_t wifi_scan_session_fetch(wifi_scan_session_t* session, wifi_ap_record_t* records, uint16_t* inout_count) {
+    ESP_RETURN_ON_FALSE(session && session->initialized, ESP_ERR_INVALID_STATE, TAG, "Session not open");
+    int64_t   start = esp_timer_get_time();
+    esp_err_t res;
+    if (records == NULL || *inout_count == 0) {
+        // Nothing to copy, only release the list held by the radio
+        *inout_count = 0;
+        res          = TRACE_CALL("esp_wifi_clear_ap_list", wifi_rpc_clear_ap_list());
+    } else {
+        res = TRACE_CALL("esp_wifi_scan_get_ap_records", wifi_rpc_scan_get_ap_records(inout_count, records));
+        if (res != ESP_OK) {
+            *inout_count = 0;
+        }
+    }
+    int64_t duration = esp_timer_get_time() - start;
+    session->last_fetch_us += duration;
+    session->total_overhead_us += duration;
+    return res;
+}
+
+void wifi_scan_session_log_stats(wifi_scan_session_t const* session) {
+    if (session->scans == 0) {
+        return;
+    }
+    ESP_LOGI(TAG,
+             "Scan %" PRIu32 ": start %" PRId64 " us, fetch %" PRId64 " us, average overhead %" PRId64
+             " us/scan, at least %" PRId64 " us/scan saved by not cycling the station",
+             session->scans, session->last_start_us, session->last_fetch_us,
+             session->total_overhead_us / session->scans, session->mode_cycle_us);
+    if (session->scans % RPC_STATS_INTERVAL == 0) {
+        wifi_scan_session_log_rpc_stats();
+    }
+}
+
+void wifi_scan_session_log_rpc_stats(void) {
+    char line[160];
+    for (wifi_rpc_call_t call = 0; call < WIFI_RPC_CALL_COUNT; call++) {
+        wifi_rpc_stats_t stats;
+        wifi_rpc_get_stats(call, &stats);
+        if (stats.calls > 0) {
+            wifi_rpc_format_stats(line, sizeof(line), call, &stats);
+            ESP_LOGI(TAG, "RPC %s", line);
+        }
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_event.h"
+#include "esp_wifi_types.h"
+
+// Every esp_wifi_* call is an RPC to the radio over esp-hosted, so the session brings
+// the station up once and keeps it running. Rescans only cost a scan start and a fetch.
+typedef struct {
+    bool     initialized;
+    uint32_t scans;              // Number of scans started through this session
+    int64_t  setup_us;           // One-time cost of bringing the station up
+    int64_t  mode_cycle_us;      // Cost of set_mode + start, paid on every scan by the old stop/start path
+    int64_t  last_start_us;      // Duration of the last esp_wifi_scan_start() call
+    int64_t  last_fetch_us;      // Duration of the AP count and record fetch of the last scan
+    int64_t  total_overhead_us;  // Sum of start and fetch durations over all scans
+} wifi_scan_session_t;
+
+// Bring up netif, the default event loop and the WiFi station. Safe to call again,
+// an already opened session is left untouched. done_handler receives WIFI_EVENT_SCAN_DONE.
+esp_err_t wifi_scan_session_open(wifi_scan_session_t* session, esp_event_handler_t done_handler, void* arg);
+
+// Start a non-blocking scan, completion is signalled through the done handler
+esp_err_t wifi_scan_session_start(wifi_scan_session_t* session, wifi_scan_config_t const* config);
+
+// Number of APs found by the finished scan
+esp_err_t wifi_scan_session_ap_count(wifi_scan_session_t* session, uint16_t* out_total);
+
+// Copy up to *inout_count records of the finished scan and release the list held by the
+// radio. Passing no buffer only releases the list.
+esp_err_t wifi_scan_session_fetch(wifi_scan_session_t* session, wifi_ap_record_t* records, uint16_t* inout_count);
+
+void wifi_scan_session_log_stats(wifi_scan_session_t const* session);
+
+// Latency histogram summary of every esp_wifi call made through the wifi_rpc shim so far
+void wifi_scan_session_log_rpc_stats(void);
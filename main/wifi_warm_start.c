@@ -0,0 +1,317 @@
+#include "wifi_warm_start.h"
+#include <inttypes.h>
+#include <string.h>
+#include "esp_check.h"
+#include "esp_event.h"
+#include "esp_log.h"
+#include "esp_netif.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "freertos/task.h"
+#include "memstat.h"
+#include "nvs.h"
+#include "sdkconfig.h"
+#include "trace.h"
+#include "wifi_rpc.h"
+#include "wifi_scan.h"
+
+#define WARM_START_NAMESPACE   "wifi_test"
+#define WARM_START_KEY         "last_ap"
+#define WARM_START_VERSION     1
+#define WARM_START_STACK_SIZE  4096
+#define WARM_START_PRIORITY    4
+#define WARM_START_SCAN_MS     15000
+#define WARM_START_TEARDOWN_MS 1000  // Wait for the disconnect event after abandoning an attempt
+
+#define WARM_BIT_CONNECTED BIT0
+#define WARM_BIT_FAILED    BIT1
+
+// Stored as a blob, bump WARM_START_VERSION when changing the layout. The password is a deliberate
+// plaintext copy: the driver's own copy lives on the radio when it runs esp-hosted and is lost
+// with WIFI_STORAGE_RAM, this one is always there. Enable NVS encryption to protect both.
+typedef struct {
+    uint8_t          version;
+    uint8_t          channel;
+    uint8_t          bssid[6];
+    uint8_t          ssid[33];
+    uint8_t          password[64];
+    wifi_auth_mode_t authmode;
+} warm_start_record_t;
+
+static char const TAG[] = "wifi_warm_start";
+
+static EventGroupHandle_t warm_events = NULL;
+static volatile bool      connected   = false;
+
+// BSSID of the directed attempt in progress. Disconnect events carrying another BSSID are left
+// over from an earlier attempt, and must not end this one or count against its BSSID.
+static portMUX_TYPE attempt_lock     = portMUX_INITIALIZER_UNLOCKED;
+static bool         attempt_directed = false;
+static uint8_t      attempt_bssid[6];
+
+static esp_err_t warm_start_load(warm_start_record_t* record) {
+    nvs_handle_t handle;
+    esp_err_t    res = nvs_open(WARM_START_NAMESPACE, NVS_READONLY, &handle);
+    if (res != ESP_OK) {
+        return res;  // Nothing stored yet
+    }
+    size_t size = sizeof(*record);
+    res         = nvs_get_blob(handle, WARM_START_KEY, record, &size);
+    nvs_close(handle);
+    if (res != ESP_OK) {
+        return res;
+    }
+    if (size != sizeof(*record) || record->version != WARM_START_VERSION) {
+        ESP_LOGW(TAG, "Ignoring stored AP with an old layout");
+        return ESP_ERR_INVALID_VERSION;
+    }
+    return ESP_OK;
+}
+
+static void warm_start_store(void) {
+    wifi_ap_record_t ap;
+    wifi_config_t    config;
+    if (TRACE_CALL("esp_wifi_sta_get_ap_info", esp_wifi_sta_get_ap_info(&ap)) != ESP_OK ||
+        TRACE_CALL("esp_wifi_get_config", esp_wifi_get_config(WIFI_IF_STA, &config)) != ESP_OK) {
+        return;
+    }
+
+    // Cleared as a whole, so the padding compares equal below
+    warm_start_record_t record;
+    memset(&record, 0, sizeof(record));
+    record.version  = WARM_START_VERSION;
+    record.channel  = ap.primary;
+    record.authmode = ap.authmode;
+    memcpy(record.bssid, ap.bssid, sizeof(record.bssid));
+    memcpy(record.ssid, config.sta.ssid, sizeof(config.sta.ssid));
+    memcpy(record.password, config.sta.password, sizeof(config.sta.password));
+
+    // Only write when something changed, to spare the flash
+    warm_start_record_t stored;
+    if (warm_start_load(&stored) == ESP_OK && memcmp(&stored, &record, sizeof(record)) == 0) {
+        return;
+    }
+
+    nvs_handle_t handle;
+    if (nvs_open(WARM_START_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS namespace");
+        return;
+    }
+    esp_err_t res = nvs_set_blob(handle, WARM_START_KEY, &record, sizeof(record));
+    if (res == ESP_OK) {
+        res = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    if (res != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to store AP: %s", esp_err_to_name(res));
+    }
+}
+
+// Runs on the default event loop task, which has little stack. Storing the AP and updating the
+// ranking is left to warm_start_task.
+static void warm_start_event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data) {
+    if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
+        connected = true;
+        xEventGroupSetBits(warm_events, WARM_BIT_CONNECTED);
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
+        wifi_event_sta_disconnected_t const* event = event_data;
+        taskENTER_CRITICAL(&attempt_lock);
+        bool stale = attempt_directed && memcmp(event->bssid, attempt_bssid, sizeof(attempt_bssid)) != 0;
+        taskEXIT_CRITICAL(&attempt_lock);
+        if (stale) {
+            return;
+        }
+        connected = false;
+        xEventGroupSetBits(warm_events, WARM_BIT_FAILED);
+    }
+}
+
+static esp_err_t warm_start_connect(warm_start_record_t const* record, bool directed) {
+    wifi_config_t config = {0};
+    memcpy(config.sta.ssid, record->ssid, sizeof(config.sta.ssid));
+    memcpy(config.sta.password, record->password, sizeof(config.sta.password));
+    config.sta.threshold.authmode = record->authmode;
+    if (directed) {
+        // Skip the all-channel sweep the driver would otherwise do before associating
+        config.sta.bssid_set   = true;
+        config.sta.channel     = record->channel;
+        config.sta.scan_method = WIFI_FAST_SCAN;
+        memcpy(config.sta.bssid, record->bssid, sizeof(config.sta.bssid));
+    } else {
+        config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+        config.sta.sort_method = WIFI_CONNECT_AP_BY_SIGNAL;
+    }
+    ESP_RETURN_ON_ERROR(TRACE_CALL("esp_wifi_set_config", wifi_rpc_set_config(WIFI_IF_STA, &config)), TAG,
+                        "Failed to set station configuration");
+
+    taskENTER_CRITICAL(&attempt_lock);
+    attempt_directed = directed;
+    memcpy(attempt_bssid, record->bssid, sizeof(attempt_bssid));
+    taskEXIT_CRITICAL(&attempt_lock);
+    xEventGroupClearBits(warm_events, WARM_BIT_CONNECTED | WARM_BIT_FAILED);
+    int64_t start = esp_timer_get_time();
+    ESP_RETURN_ON_ERROR(TRACE_CALL("esp_wifi_connect", esp_wifi_connect()), TAG, "Failed to start connecting");
+
+    EventBits_t bits = xEventGroupWaitBits(warm_events, WARM_BIT_CONNECTED | WARM_BIT_FAILED, pdFALSE, pdFALSE,
+                                           pdMS_TO_TICKS(CONFIG_WIFI_TEST_CONNECT_TIMEOUT_MS));
+    if (directed && wifi_scan_cache_acquire()) {
+        // Feeds the ranking, so a BSSID that keeps failing is not tried first again
+        ap_rank_report(wifi_scan_rank(), record->bssid, (bits & WARM_BIT_CONNECTED) != 0);
+        wifi_scan_cache_release();
+    }
+    if (bits & WARM_BIT_CONNECTED) {
+        ESP_LOGI(TAG, "%s connect to %s took %" PRId64 " ms", directed ? "Directed" : "Full sweep", record->ssid,
+                 (esp_timer_get_time() - start) / 1000);
+        return ESP_OK;
+    }
+    if (bits & WARM_BIT_FAILED) {
+        return ESP_FAIL;  // The station is disconnected already
+    }
+    // Still associating. Wait for the disconnect event, so it cannot end the next attempt.
+    TRACE_CALL("esp_wifi_disconnect", esp_wifi_disconnect());
+    xEventGroupWaitBits(warm_events, WARM_BIT_FAILED, pdFALSE, pdFALSE, pdMS_TO_TICKS(WARM_START_TEARDOWN_MS));
+    return ESP_ERR_TIMEOUT;
+}
+
+// Try the best ranked APs of the network one by one, each with a directed connect. Called with
+// the radio held, which is handed back to the scan task for the duration of the scan.
+static esp_err_t warm_start_connect_ranked(warm_start_record_t const* record) {
+    ap_rank_candidate_t candidates[AP_RANK_MAX_CANDIDATES];
+    uint8_t             count = 0;
+
+    wifi_scan_radio_release();
+    esp_err_t res = wifi_scan_request_wait(pdMS_TO_TICKS(WARM_START_SCAN_MS));
+    if (wifi_scan_radio_acquire(portMAX_DELAY) != ESP_OK || res != ESP_OK) {
+        return ESP_ERR_TIMEOUT;
+    }
+    ap_rank_t* rank = wifi_scan_rank();
+    if (wifi_scan_cache_acquire()) {
+        count = rank->count < CONFIG_WIFI_TEST_CONNECT_CANDIDATES ? rank->count : CONFIG_WIFI_TEST_CONNECT_CANDIDATES;
+        memcpy(candidates, rank->candidates, count * sizeof(candidates[0]));
+        wifi_scan_cache_release();
+    }
+    if (count == 0) {
+        ESP_LOGW(TAG, "No AP of %s found", record->ssid);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    res = ESP_FAIL;
+    for (uint8_t i = 0; i < count && res != ESP_OK; i++) {
+        ap_rank_candidate_t const* candidate = &candidates[i];
+        ESP_LOGI(TAG,
+                 "Trying %02x:%02x:%02x:%02x:%02x:%02x on channel %u, score %d (signal %d, PHY %d, security %d, "
+                 "congestion -%d, failures -%d)",
+                 candidate->bssid[0], candidate->bssid[1], candidate->bssid[2], candidate->bssid[3],
+                 candidate->bssid[4], candidate->bssid[5], candidate->channel, candidate->score, candidate->signal,
+                 candidate->phy, candidate->security, candidate->congestion, candidate->failures);
+        warm_start_record_t target = *record;
+        target.channel             = candidate->channel;
+        target.authmode            = candidate->authmode;
+        memcpy(target.bssid, candidate->bssid, sizeof(target.bssid));
+        res = warm_start_connect(&target, true);
+    }
+    return res;
+}
+
+static void warm_start_task(void* arg) {
+    warm_start_record_t record;
+    bool                have_record = warm_start_load(&record) == ESP_OK;
+    if (!have_record) {
+        memset(&record, 0, sizeof(record));
+        strlcpy((char*)record.ssid, CONFIG_WIFI_TEST_STA_SSID, sizeof(record.ssid));
+        strlcpy((char*)record.password, CONFIG_WIFI_TEST_STA_PASSWORD, sizeof(record.password));
+        record.authmode = record.password[0] ? WIFI_AUTH_WPA2_PSK : WIFI_AUTH_OPEN;
+    }
+    if (record.ssid[0] == '\0') {
+        ESP_LOGI(TAG, "No network configured, not connecting");
+        wifi_scan_request();
+        memstat_task_exit();
+        return;
+    }
+
+    if (wifi_scan_cache_acquire()) {
+        ap_rank_set_target(wifi_scan_rank(), (char const*)record.ssid);
+        wifi_scan_cache_release();
+    }
+
+    // The default event loop exists once the scan task has brought up the station
+    if (wifi_scan_wait_ready(portMAX_DELAY) != ESP_OK ||
+        esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, warm_start_event_handler, NULL) != ESP_OK ||
+        esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, warm_start_event_handler, NULL) !=
+            ESP_OK ||
+        wifi_scan_radio_acquire(portMAX_DELAY) != ESP_OK) {
+        ESP_LOGE(TAG, "WiFi station not available");
+        memstat_task_exit();
+        return;
+    }
+
+    esp_err_t res = ESP_FAIL;
+    if (have_record) {
+        res = warm_start_connect(&record, true);
+        if (res != ESP_OK) {
+            ESP_LOGW(TAG, "Stored AP not reachable on channel %u, falling back to a full sweep", record.channel);
+        }
+    }
+    if (res != ESP_OK && CONFIG_WIFI_TEST_CONNECT_CANDIDATES > 0) {
+        res = warm_start_connect_ranked(&record);
+    }
+    if (res != ESP_OK) {
+        res = warm_start_connect(&record, false);
+    }
+    if (res != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to connect to %s: %s", record.ssid, esp_err_to_name(res));
+    }
+
+    wifi_scan_radio_release();
+    wifi_scan_request();
+
+    // Follow the connection from here on. A successful attempt leaves WARM_BIT_CONNECTED set, so
+    // the AP it connected to is stored right away.
+    taskENTER_CRITICAL(&attempt_lock);
+    attempt_directed = false;
+    taskEXIT_CRITICAL(&attempt_lock);
+    while (1) {
+        EventBits_t bits =
+            xEventGroupWaitBits(warm_events, WARM_BIT_CONNECTED | WARM_BIT_FAILED, pdTRUE, pdFALSE, portMAX_DELAY);
+        if ((bits & WARM_BIT_FAILED) && !connected && wifi_scan_cache_acquire()) {
+            ap_rank_disconnected(wifi_scan_rank());
+            wifi_scan_cache_release();
+        }
+        if ((bits & WARM_BIT_CONNECTED) && connected) {
+            ESP_LOGI(TAG, "Connected %" PRId64 " ms after boot", esp_timer_get_time() / 1000);
+            warm_start_store();
+        }
+    }
+}
+
+esp_err_t wifi_warm_start_begin(void) {
+    if (warm_events != NULL) {
+        return ESP_OK;
+    }
+    warm_events = xEventGroupCreate();
+    if (warm_events == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (memstat_task_create(warm_start_task, "warm_start", WARM_START_STACK_SIZE, NULL, WARM_START_PRIORITY, NULL,
+                            tskNO_AFFINITY) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+bool wifi_warm_start_connected(void) {
+    return connected;
+}
+
+esp_err_t wifi_warm_start_forget(void) {
+    nvs_handle_t handle;
+    ESP_RETURN_ON_ERROR(nvs_open(WARM_START_NAMESPACE, NVS_READWRITE, &handle), TAG, "Failed to open NVS namespace");
+    esp_err_t res = nvs_erase_key(handle, WARM_START_KEY);
+    if (res == ESP_OK) {
+        res = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    return res == ESP_ERR_NVS_NOT_FOUND ? ESP_OK : res;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stdbool.h>
+#include "esp_err.h"
+
+// Connect as soon as the station is up. The AP of the last successful connection is stored
+// in NVS and tried first by BSSID on its channel; only when that fails does the driver sweep
+// all channels. Boot-to-connected latency is logged for every connection. The first scan is
+// requested once the connection attempt is over, so it does not delay associating. The task
+// then stays around to store the AP of every later connection.
+esp_err_t wifi_warm_start_begin(void);
+
+bool wifi_warm_start_connected(void);
+
+// Remove the stored AP, the next boot starts with a full sweep
+esp_err_t wifi_warm_start_forget(void);